@@ -0,0 +1,220 @@
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "compiler.h"
+#include "scanner.h"
+#include "parser.h"
+#include "visitor.h"
+#include "labelvisitor.h"
+#include "typechecker.h"
+#include "generador.h"
+
+using namespace std;
+
+// Benchmarks de rendimiento del compilador: scanner, parser, tipos,
+// etiquetado y codegen por separado y de punta a punta, sobre programas sintéticos.
+// "total" construye el Program entero; "porfuncion" es el pipeline de
+// CompilerContext que genera cada función apenas se parsea.
+//
+// --estres[=N] compila en cambio un programa con cadenas de N términos
+// (10^6 por omisión) por los dos caminos y falla si alguno no termina.
+
+struct Caso {
+    string nombre;
+    size_t bytes;
+    long unidades;
+    const char* unidad;
+    function<void()> cuerpo;
+};
+
+static double ahora() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void ejecutar(const Caso& c, double tiempoMinimo) {
+    c.cuerpo();
+    long iteraciones = 0;
+    double mejor = 1e300, total = 0;
+    while (total < tiempoMinimo || iteraciones < 3) {
+        double t0 = ahora();
+        c.cuerpo();
+        double dt = ahora() - t0;
+        mejor = min(mejor, dt);
+        total += dt;
+        iteraciones++;
+    }
+    double medio = total / iteraciones;
+    cout << left << setw(28) << c.nombre << right << fixed << setprecision(3)
+         << setw(12) << medio * 1e3 << " ms"
+         << setw(12) << mejor * 1e3 << " ms"
+         << setw(10) << iteraciones
+         << setw(12) << c.bytes / medio / 1e6 << " MB/s"
+         << setw(14) << setprecision(0) << c.unidades / medio << " " << c.unidad << "/s\n";
+}
+
+static long contarTokens(const string& fuente) {
+    Scanner scanner(fuente.c_str());
+    long n = 0;
+    Token* tok;
+    while ((tok = scanner.nextToken())->type != Token::END) {
+        n++;
+        delete tok;
+    }
+    delete tok;
+    return n;
+}
+
+static Program* parsear(const string& fuente) {
+    Scanner scanner(fuente.c_str());
+    Parser parser(&scanner);
+    return parser.parseProgram();
+}
+
+static bool verificarTipos(Program* p) {
+    TypeChecker tipos;
+    tipos.declararGlobales(p->vardecs);
+    for (auto f : p->fundecs->Fundecs) tipos.declararFuncion(f);
+    for (auto f : p->fundecs->Fundecs) tipos.verificar(f);
+    return !tipos.hayErrores();
+}
+
+static int estres(int terminos) {
+    OpcionesGenerador op;
+    op.forma = "cadena";
+    op.tamano = terminos;
+    string fuente = generarPrograma(op);
+    cout << "estres: " << terminos << " términos, " << fuente.size() << " bytes de fuente" << endl;
+
+    double t0 = ahora();
+    CompilerContext contexto;
+    Emitter salida;
+    if (!contexto.compile(fuente, CompileOptions(), salida)) {
+        cout << "estres: porfuncion falló" << endl;
+        return 1;
+    }
+    double t1 = ahora();
+    size_t lineas = salida.lineas();
+    cout << "  porfuncion   " << fixed << setprecision(3) << (t1 - t0) * 1e3 << " ms, "
+         << lineas << " lineas" << endl;
+
+    salida.clear();
+    Program* p = parsear(fuente);
+    double t2 = ahora();
+    verificarTipos(p);
+    double tt = ahora();
+    LabelVisitor l;
+    l.visit(p);
+    double t3 = ahora();
+    {
+        GenCodeVisitor codigo(salida);
+        codigo.generar(p);
+    }
+    double t4 = ahora();
+    delete p;
+    double t5 = ahora();
+    cout << "  parser       " << (t2 - t1) * 1e3 << " ms\n"
+         << "  tipos        " << (tt - t2) * 1e3 << " ms\n"
+         << "  etiquetado   " << (t3 - tt) * 1e3 << " ms\n"
+         << "  codegen      " << (t4 - t3) * 1e3 << " ms\n"
+         << "  destruccion  " << (t5 - t4) * 1e3 << " ms" << endl;
+    if (salida.lineas() != lineas) {
+        cout << "estres: los dos caminos generaron salidas distintas" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, const char* argv[]) {
+    OpcionesGenerador base;
+    base.tamano = 2000;
+    string filtro;
+    string soloGenerar;
+    double tiempoMinimo = 0.5;
+    int terminosEstres = 0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--tamano=", 0) == 0) base.tamano = atoi(arg.c_str() + 9);
+        else if (arg.rfind("--profundidad=", 0) == 0) base.profundidad = atoi(arg.c_str() + 14);
+        else if (arg.rfind("--semilla=", 0) == 0) base.semilla = strtoul(arg.c_str() + 10, nullptr, 10);
+        else if (arg.rfind("--filtro=", 0) == 0) filtro = arg.substr(9);
+        else if (arg.rfind("--tiempo=", 0) == 0) tiempoMinimo = atof(arg.c_str() + 9);
+        else if (arg.rfind("--generar=", 0) == 0) soloGenerar = arg.substr(10);
+        else if (arg == "--estres") terminosEstres = 1000000;
+        else if (arg.rfind("--estres=", 0) == 0) terminosEstres = max(1, atoi(arg.c_str() + 9));
+        else {
+            cerr << "Uso: " << argv[0] << " [--tamano=N] [--profundidad=N] [--semilla=N]"
+                 << " [--filtro=texto] [--tiempo=segundos] [--generar=forma] [--estres[=N]]" << endl;
+            return 1;
+        }
+    }
+
+    if (terminosEstres > 0) return estres(terminosEstres);
+
+    if (!soloGenerar.empty()) {
+        base.forma = soloGenerar;
+        cout << generarPrograma(base);
+        return 0;
+    }
+
+    cout << left << setw(28) << "benchmark" << right << setw(15) << "medio" << setw(15) << "mejor"
+         << setw(10) << "iter" << setw(17) << "fuente" << setw(18) << "throughput" << "\n";
+
+    for (const char* forma : {"expr", "funcs", "stmts", "nested", "mixed"}) {
+        OpcionesGenerador op = base;
+        op.forma = forma;
+        string fuente = generarPrograma(op);
+        long tokens = contarTokens(fuente);
+        Program* programa = parsear(fuente);
+        if (!verificarTipos(programa)) {
+            cerr << "el programa generado para " << forma << " no verifica sus tipos" << endl;
+            return 1;
+        }
+        LabelVisitor etiquetador;
+        etiquetador.visit(programa);
+        Emitter salida;
+        {
+            GenCodeVisitor codigo(salida);
+            codigo.generar(programa);
+        }
+        long lineas = (long) salida.lineas();
+        CompilerContext contexto;
+
+        vector<Caso> casos = {
+            {"scanner/" + op.forma, fuente.size(), tokens, "tokens", [&] { contarTokens(fuente); }},
+            {"parser/" + op.forma, fuente.size(), tokens, "tokens", [&] { delete parsear(fuente); }},
+            {"tipos/" + op.forma, fuente.size(), tokens, "tokens", [&] { verificarTipos(programa); }},
+            {"etiquetado/" + op.forma, fuente.size(), tokens, "tokens", [&] {
+                LabelVisitor l;
+                l.visit(programa);
+            }},
+            {"codegen/" + op.forma, fuente.size(), lineas, "lineas", [&] {
+                salida.clear();
+                GenCodeVisitor codigo(salida);
+                codigo.generar(programa);
+            }},
+            {"total/" + op.forma, fuente.size(), tokens, "tokens", [&] {
+                Program* p = parsear(fuente);
+                verificarTipos(p);
+                LabelVisitor l;
+                l.visit(p);
+                salida.clear();
+                GenCodeVisitor codigo(salida);
+                codigo.generar(p);
+                delete p;
+            }},
+            {"porfuncion/" + op.forma, fuente.size(), tokens, "tokens", [&] {
+                salida.clear();
+                contexto.compile(fuente, CompileOptions(), salida);
+            }},
+        };
+        for (auto& c : casos) {
+            if (filtro.empty() || c.nombre.find(filtro) != string::npos) ejecutar(c, tiempoMinimo);
+        }
+        delete programa;
+    }
+    return 0;
+}
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sstream>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "compiler.h"
+#include "perfil.h"
+
+using namespace std;
+
+// Benchmarks de ejecución del código generado. Cada programa del corpus se
+// compila con GenCodeVisitor, se ensambla y enlaza con gcc, se ejecuta
+// varias veces y su salida se compara con <programa>.esperado. Reporta el
+// tiempo de ejecución, las instrucciones ejecutadas (perf_event_open, si
+// el kernel lo permite) y el tamaño de .text.
+//
+// <programa>.esperado contiene la salida literal, o bien una línea
+// "#fnv1a <hash> <bytes>" para salidas grandes.
+//
+// Con --pgo cada programa se compila primero instrumentado, se ejecuta una
+// vez para obtener su perfil y lo que se mide es la compilación con ese
+// perfil (--profile-use).
+
+struct Medicion {
+    double mejor = 1e300;
+    double medio = 0;
+    long instrucciones = -1;
+    long tamanoTexto = -1;
+    bool correcto = true;
+    string error;
+};
+
+static double ahora() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool leerArchivo(const string& ruta, string& contenido) {
+    ifstream in(ruta, ios::binary);
+    if (!in.is_open()) return false;
+    stringstream ss;
+    ss << in.rdbuf();
+    contenido = ss.str();
+    return true;
+}
+
+static uint64_t fnv1a(const string& s) {
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static bool salidaEsperada(const string& esperado, const string& salida) {
+    if (esperado.rfind("#fnv1a ", 0) == 0) {
+        istringstream in(esperado.substr(7));
+        uint64_t hash;
+        size_t bytes;
+        in >> hex >> hash >> dec >> bytes;
+        return fnv1a(salida) == hash && salida.size() == bytes;
+    }
+    return esperado == salida;
+}
+
+static bool compilar(CompilerContext& contexto, const string& fuente, const CompileOptions& opciones, const string& rutaAsm) {
+    int fd = open(rutaAsm.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    bool ok;
+    {
+        Emitter salida(fd);
+        ok = contexto.compile(fuente, opciones, salida) && salida.flush();
+    }
+    close(fd);
+    return ok;
+}
+
+static int ejecutarComando(const vector<string>& args) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        vector<char*> argv;
+        for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int estado;
+    waitpid(pid, &estado, 0);
+    return WIFEXITED(estado) ? WEXITSTATUS(estado) : -1;
+}
+
+static long tamanoTexto(const string& objeto) {
+    string elf;
+    if (!leerArchivo(objeto, elf) || elf.size() < sizeof(Elf64_Ehdr)) return -1;
+    auto* eh = (const Elf64_Ehdr*) elf.data();
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64) return -1;
+    if (eh->e_shoff + (size_t) eh->e_shnum * sizeof(Elf64_Shdr) > elf.size()) return -1;
+    auto* sh = (const Elf64_Shdr*) (elf.data() + eh->e_shoff);
+    const char* nombres = elf.data() + sh[eh->e_shstrndx].sh_offset;
+    long total = 0;
+    for (int i = 0; i < eh->e_shnum; i++) {
+        if (sh[i].sh_type == SHT_PROGBITS && (sh[i].sh_flags & SHF_EXECINSTR) &&
+            strncmp(nombres + sh[i].sh_name, ".text", 5) == 0) {
+            total += sh[i].sh_size;
+        }
+    }
+    return total;
+}
+
+static int abrirContador(pid_t pid) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+// Ejecuta el binario una vez; devuelve la salida estándar, el tiempo de
+// pared y las instrucciones de usuario (-1 si no hay contador).
+static bool ejecutarPrograma(const string& binario, string& salida, double& segundos, long& instrucciones) {
+    int salidaPipe[2], arranque[2];
+    if (pipe(salidaPipe) < 0 || pipe(arranque) < 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(salidaPipe[0]);
+        close(arranque[1]);
+        dup2(salidaPipe[1], STDOUT_FILENO);
+        char c;
+        if (read(arranque[0], &c, 1) != 1) _exit(126);
+        execl(binario.c_str(), binario.c_str(), (char*) nullptr);
+        _exit(127);
+    }
+    close(salidaPipe[1]);
+    close(arranque[0]);
+    int contador = abrirContador(pid);
+    double t0 = ahora();
+    if (write(arranque[1], "x", 1) != 1) return false;
+    close(arranque[1]);
+    salida.clear();
+    char buffer[1 << 16];
+    ssize_t n;
+    while ((n = read(salidaPipe[0], buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        salida.append(buffer, n);
+    }
+    close(salidaPipe[0]);
+    int estado;
+    waitpid(pid, &estado, 0);
+    segundos = ahora() - t0;
+    instrucciones = -1;
+    if (contador >= 0) {
+        long long valor;
+        if (read(contador, &valor, sizeof(valor)) == sizeof(valor)) instrucciones = valor;
+        close(contador);
+    }
+    return WIFEXITED(estado) && WEXITSTATUS(estado) == 0;
+}
+
+static bool ensamblar(const string& base) {
+    return ejecutarComando({"gcc", "-c", base + ".s", "-o", base + ".o"}) == 0 &&
+           ejecutarComando({"gcc", base + ".o", "-o", base}) == 0;
+}
+
+static Medicion medir(CompilerContext& contexto, CompileOptions opciones, bool pgo, const string& dir,
+                      const string& nombre, const string& trabajo, int repeticiones) {
+    Medicion m;
+    string fuente, esperado;
+    if (!leerArchivo(dir + "/" + nombre + ".txt", fuente)) {
+        m.correcto = false;
+        m.error = "no se pudo leer el fuente";
+        return m;
+    }
+    bool conEsperado = leerArchivo(dir + "/" + nombre + ".esperado", esperado);
+    string base = trabajo + "/" + nombre;
+    Perfil perfil;
+    if (pgo) {
+        CompileOptions entrenamiento = opciones;
+        entrenamiento.perfilGenerar = base + ".perfil";
+        string salida, error;
+        double segundos;
+        long instrucciones;
+        if (!compilar(contexto, fuente, entrenamiento, base + ".s") || !ensamblar(base) ||
+            !ejecutarPrograma(base, salida, segundos, instrucciones) ||
+            !perfil.cargar(entrenamiento.perfilGenerar, error)) {
+            m.correcto = false;
+            m.error = "fallo al obtener el perfil";
+            return m;
+        }
+        opciones.optimizacion.perfil = &perfil;
+    }
+    if (!compilar(contexto, fuente, opciones, base + ".s")) {
+        m.correcto = false;
+        m.error = "fallo al generar ensamblador";
+        return m;
+    }
+    if (!ensamblar(base)) {
+        m.correcto = false;
+        m.error = "fallo al ensamblar/enlazar";
+        return m;
+    }
+    m.tamanoTexto = tamanoTexto(base + ".o");
+    double total = 0;
+    for (int i = 0; i < repeticiones; i++) {
+        string salida;
+        double segundos;
+        long instrucciones;
+        if (!ejecutarPrograma(base, salida, segundos, instrucciones)) {
+            m.correcto = false;
+            m.error = "el programa terminó con error";
+            return m;
+        }
+        if (conEsperado && !salidaEsperada(esperado, salida)) {
+            m.correcto = false;
+            m.error = "salida distinta de la esperada";
+        }
+        m.mejor = min(m.mejor, segundos);
+        total += segundos;
+        if (instrucciones >= 0) m.instrucciones = instrucciones;
+    }
+    m.medio = total / repeticiones;
+    return m;
+}
+
+int main(int argc, const char* argv[]) {
+    string dir = "bench/programas";
+    string trabajo = "/tmp/lab20-runbench";
+    string filtro;
+    int repeticiones = 5;
+    bool json = false;
+    bool pgo = false;
+    bool avx2 = false;
+    CompileOptions opciones;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--dir=", 0) == 0) dir = arg.substr(6);
+        else if (arg.rfind("--trabajo=", 0) == 0) trabajo = arg.substr(10);
+        else if (arg.rfind("--filtro=", 0) == 0) filtro = arg.substr(9);
+        else if (arg.rfind("--repeticiones=", 0) == 0) repeticiones = max(1, atoi(arg.c_str() + 15));
+        else if (arg.rfind("--unroll=", 0) == 0) opciones.optimizacion.desenrollar = atoi(arg.c_str() + 9);
+        else if (arg == "-O1") {
+            opciones.optimizacion.desenrollar = 4;
+            opciones.optimizacion.vectorizar = 2;
+        }
+        else if (arg == "-mavx2") avx2 = true;
+        else if (arg == "--pgo") pgo = true;
+        else if (arg == "--memoize") opciones.memoizar = true;
+        else if (arg == "--ipcp") opciones.especializar = PRESUPUESTO_ESPECIALIZACION;
+        else if (arg == "--json") json = true;
+        else {
+            cerr << "Uso: " << argv[0] << " [--dir=corpus] [--trabajo=dir] [--filtro=texto]"
+                 << " [--repeticiones=N] [-O1 [-mavx2]|--unroll=N] [--pgo] [--memoize] [--ipcp] [--json]" << endl;
+            return 1;
+        }
+    }
+    if (avx2 && opciones.optimizacion.vectorizar) opciones.optimizacion.vectorizar = 4;
+    mkdir(trabajo.c_str(), 0755);
+
+    vector<string> nombres;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        cerr << "No se pudo abrir el corpus: " << dir << endl;
+        return 1;
+    }
+    while (dirent* e = readdir(d)) {
+        string f = e->d_name;
+        if (f.size() > 4 && f.compare(f.size() - 4, 4, ".txt") == 0) {
+            string nombre = f.substr(0, f.size() - 4);
+            if (filtro.empty() || nombre.find(filtro) != string::npos) nombres.push_back(nombre);
+        }
+    }
+    closedir(d);
+    sort(nombres.begin(), nombres.end());
+
+    CompilerContext contexto;
+    int fallos = 0;
+    if (json) cout << "[";
+    else cout << left << setw(16) << "programa" << right << setw(12) << "medio" << setw(12) << "mejor"
+              << setw(16) << "instrucciones" << setw(10) << ".text" << "  estado\n";
+    for (size_t i = 0; i < nombres.size(); i++) {
+        Medicion m = medir(contexto, opciones, pgo, dir, nombres[i], trabajo, repeticiones);
+        if (!m.correcto) fallos++;
+        if (json) {
+            cout << (i ? ",\n " : "\n ") << "{\"programa\": \"" << nombres[i] << "\", \"medio_s\": "
+                 << m.medio << ", \"mejor_s\": " << m.mejor << ", \"instrucciones\": " << m.instrucciones
+                 << ", \"texto_bytes\": " << m.tamanoTexto << ", \"correcto\": "
+                 << (m.correcto ? "true" : "false") << "}";
+        } else {
+            cout << left << setw(16) << nombres[i] << right << fixed << setprecision(3)
+                 << setw(9) << m.medio * 1e3 << " ms" << setw(9) << m.mejor * 1e3 << " ms"
+                 << setw(16) << (m.instrucciones >= 0 ? to_string(m.instrucciones) : "n/a")
+                 << setw(10) << m.tamanoTexto << "  " << (m.correcto ? "ok" : m.error) << "\n";
+        }
+    }
+    if (json) cout << "\n]\n";
+    return fallos == 0 ? 0 : 1;
+}
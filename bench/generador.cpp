@@ -0,0 +1,181 @@
+#include <cstdint>
+#include <sstream>
+#include "generador.h"
+
+using namespace std;
+
+namespace {
+
+class Generador {
+public:
+    Generador(const OpcionesGenerador& o) : op(o), estado(o.semilla ? o.semilla : 1) {}
+
+    string programa() {
+        out << "var int g;\n";
+        if (op.forma == "expr") formaExpr();
+        else if (op.forma == "funcs") formaFuncs();
+        else if (op.forma == "stmts") formaStmts();
+        else if (op.forma == "nested") formaNested();
+        else if (op.forma == "cadena") formaCadena();
+        else formaMixed();
+        return out.str();
+    }
+
+private:
+    const OpcionesGenerador& op;
+    uint32_t estado;
+    ostringstream out;
+
+    uint32_t azar(uint32_t n) {
+        // xorshift32: mismo resultado en cualquier plataforma
+        estado ^= estado << 13;
+        estado ^= estado >> 17;
+        estado ^= estado << 5;
+        return estado % n;
+    }
+
+    const char* variable() {
+        static const char* vars[] = {"a", "b", "c", "d", "g"};
+        return vars[azar(5)];
+    }
+
+    void hoja() {
+        if (azar(3) == 0) out << azar(100);
+        else out << variable();
+    }
+
+    void arbol(int profundidad) {
+        if (profundidad == 0) {
+            hoja();
+            return;
+        }
+        static const char* ops[] = {" + ", " - ", " * "};
+        out << "(";
+        arbol(profundidad - 1);
+        out << ops[azar(3)];
+        arbol(profundidad - 1);
+        out << ")";
+    }
+
+    void cadena(int largo) {
+        hoja();
+        for (int i = 1; i < largo; i++) {
+            out << (azar(2) ? " + " : " - ");
+            hoja();
+        }
+    }
+
+    void cabecera(const string& nombre) {
+        out << "fun int " << nombre << "(int a, int b)\n var int c, d, i;\n c = a;\n d = b;\n i = 0;\n";
+    }
+
+    void funcionMain(const string& llamada) {
+        out << "fun int main()\n var int r;\n g = 1;\n r = " << llamada << ";\n print(r);\n return(0)\nendfun\n";
+    }
+
+    void formaExpr() {
+        int n = op.tamano / 100 + 1;
+        for (int f = 0; f < n; f++) {
+            cabecera("f" + to_string(f));
+            out << " c = ";
+            arbol(op.profundidad);
+            out << ";\n d = ";
+            cadena(100);
+            out << ";\n return(c + d)\nendfun\n";
+        }
+        funcionMain("f0(3, 4)");
+    }
+
+    void formaFuncs() {
+        for (int f = 0; f < op.tamano; f++) {
+            cabecera("f" + to_string(f));
+            out << " c = c * " << azar(10) << " + d;\n";
+            if (f > 0) out << " c = c + f" << azar(f) << "(0, d);\n";
+            out << " return(c)\nendfun\n";
+        }
+        funcionMain("f0(1, 2)");
+    }
+
+    void formaStmts() {
+        cabecera("f0");
+        for (int s = 0; s < op.tamano; s++) {
+            out << " " << (azar(2) ? "c" : "d") << " = ";
+            arbol(1 + azar(2));
+            out << ";\n";
+        }
+        out << " return(c + d)\nendfun\n";
+        funcionMain("f0(1, 2)");
+    }
+
+    void anidado(int profundidad, int sangria) {
+        string pre(sangria, ' ');
+        if (profundidad == 0) {
+            out << pre << "c = c + " << variable() << "\n";
+            return;
+        }
+        if (azar(2)) {
+            out << pre << "if c < " << azar(1000) << " then\n";
+            anidado(profundidad - 1, sangria + 1);
+            out << pre << "else\n";
+            anidado(profundidad - 1, sangria + 1);
+            out << pre << "endif\n";
+        } else {
+            out << pre << "i = 0;\n";
+            out << pre << "while i < 2 do\n";
+            anidado(profundidad - 1, sangria + 1);
+            out << pre << "; i = i + 1\n";
+            out << pre << "endwhile\n";
+        }
+    }
+
+    void formaNested() {
+        int n = op.tamano / 50 + 1;
+        for (int f = 0; f < n; f++) {
+            cabecera("f" + to_string(f));
+            anidado(op.profundidad, 1);
+            out << " ;\n return(c)\nendfun\n";
+        }
+        funcionMain("f0(1, 2)");
+    }
+
+    void formaCadena() {
+        out << "fun int f1(int a, int b)\n return(a + b)\nendfun\n";
+        cabecera("f0");
+        out << " c = ";
+        cadena(op.tamano);
+        out << ";\n d = ";
+        for (int i = 1; i < op.tamano; i++) {
+            hoja();
+            out << " - (";
+        }
+        hoja();
+        out << string(op.tamano - 1, ')') << ";\n c = c + ";
+        for (int i = 0; i < op.tamano; i++) out << "f1(";
+        out << "1";
+        for (int i = 0; i < op.tamano; i++) out << ", d)";
+        out << ";\n return(c + d)\nendfun\n";
+        funcionMain("f0(1, 2)");
+    }
+
+    void formaMixed() {
+        int n = op.tamano / 20 + 1;
+        for (int f = 0; f < n; f++) {
+            cabecera("f" + to_string(f));
+            out << " while i < a do\n  c = c + ";
+            arbol(3);
+            out << ";\n  if c < d then\n   d = d - 1\n  else\n   d = ";
+            cadena(8);
+            out << "\n  endif;\n  i = i + 1\n endwhile;\n";
+            if (f > 0) out << " c = c + f" << azar(f) << "(1, c);\n";
+            out << " return(c)\nendfun\n";
+        }
+        funcionMain("f0(3, 4)");
+    }
+};
+
+}
+
+string generarPrograma(const OpcionesGenerador& opciones) {
+    Generador g(opciones);
+    return g.programa();
+}
@@ -0,0 +1,26 @@
+#ifndef GENERADOR_H
+#define GENERADOR_H
+
+#include <string>
+using namespace std;
+
+// Generador determinista de programas de prueba. Con la misma semilla y
+// las mismas opciones produce siempre el mismo fuente.
+//   expr     expresiones profundas (árboles balanceados y cadenas largas)
+//   funcs    muchas funciones pequeñas que se llaman entre sí
+//   stmts    una lista larga de sentencias en main
+//   nested   while/if anidados hasta la profundidad pedida
+//   mixed    un poco de todo
+//   cadena   expresiones de `tamano` términos: a + b + ..., a - (b - (...))
+//            y llamadas anidadas f1(f1(...)); prueba de estrés, no entra
+//            en la tabla de benchmarks
+struct OpcionesGenerador {
+    string forma = "mixed";
+    int tamano = 1000;
+    int profundidad = 8;
+    unsigned semilla = 12345;
+};
+
+string generarPrograma(const OpcionesGenerador& opciones);
+
+#endif // GENERADOR_H
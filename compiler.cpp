@@ -0,0 +1,238 @@
+#include "token.h"
+#include "scanner.h"
+#include "parser.h"
+#include "visitor.h"
+#include "labelvisitor.h"
+#include "typechecker.h"
+#include "inliner.h"
+#include "memoizacion.h"
+#include "especializacion.h"
+#include "compiler.h"
+
+using namespace std;
+
+bool CompilerContext::compile(string_view fuente, const CompileOptions& opciones, Emitter& sink) {
+    errores.clear();
+    Stats* stats = opciones.stats;
+    if (stats) {
+        sink.medir();
+        stats->contar("bytes_entrada", fuente.size());
+    }
+
+    bool ok;
+    if (opciones.incremental && !opciones.programaCompleto()) {
+        if (stats) stats->iniciarFase("incremental");
+        ok = incremental.compilar(fuente, sink, opciones.optimizacion, opciones.fuenteDepuracion);
+        sink.flush();
+        if (stats) {
+            stats->terminarFase();
+            stats->contar("funciones", incremental.reutilizadas + incremental.regeneradas);
+            stats->contar("funciones_reutilizadas", incremental.reutilizadas);
+        }
+        if (!ok) errores = incremental.diagnosticos;
+    } else if (opciones.porFuncion && !opciones.programaCompleto()) {
+        ok = compilarPorFuncion(fuente, opciones, sink);
+    } else {
+        ok = compilarCompleto(fuente, opciones, sink);
+    }
+    if (ok && stats) {
+        stats->contar("instrucciones", sink.instrucciones());
+        stats->contar("lineas_salida", sink.lineas());
+        stats->contar("bytes_salida", sink.bytesEscritos() + sink.size());
+    }
+    return ok;
+}
+
+// Cuenta en stats lo que hizo el optimizador.
+static void contarOptimizaciones(Stats* stats, const Optimizer& optimizador) {
+    stats->contar("bucles_desenrollados", optimizador.desenrollados);
+    stats->contar("bucles_completos", optimizador.completos);
+    stats->contar("bucles_vectorizados", optimizador.vectorizados);
+    stats->contar("constantes_plegadas", optimizador.plegadas);
+    stats->contar("ramas_eliminadas", optimizador.ramasEliminadas);
+}
+
+bool CompilerContext::compilarCompleto(string_view fuente, const CompileOptions& opciones, Emitter& sink) {
+    Stats* stats = opciones.stats;
+    if (stats) stats->iniciarFase("parser");
+    Scanner scanner(fuente);
+    scanner.medir(stats);
+    Parser parser(&scanner);
+    Program* program = parser.parseProgram();
+    if (stats) stats->terminarFase();
+    if (parser.hasErrors()) {
+        errores = parser.errores();
+        delete program;
+        return false;
+    }
+
+    if (stats) stats->iniciarFase("tipos");
+    TypeChecker tipos;
+    tipos.declararGlobales(program->vardecs);
+    for (auto f : program->fundecs->Fundecs) tipos.declararFuncion(f);
+    for (auto f : program->fundecs->Fundecs) tipos.verificar(f);
+    if (stats) stats->terminarFase();
+    if (tipos.hayErrores()) {
+        errores = tipos.errores();
+        delete program;
+        return false;
+    }
+
+    unordered_map<string, bool> globales;
+    for (auto dec : program->vardecs->vardecs) {
+        for (auto& v : dec->vars) globales[v] = true;
+    }
+    bool instrumentar = !opciones.perfilGenerar.empty();
+    const Perfil* perfil = opciones.optimizacion.perfil;
+    long expandidas = 0;
+    if (opciones.conPerfil()) {
+        if (stats) stats->iniciarFase("perfil");
+        for (auto f : program->fundecs->Fundecs) numerarSitios(f);
+        if (perfil) {
+            perfil->ordenar(program->fundecs->Fundecs);
+            Inliner inliner(*perfil, program->fundecs->Fundecs, globales);
+            for (auto f : program->fundecs->Fundecs) inliner.expandir(f);
+            expandidas = inliner.expandidas;
+        }
+        if (stats) stats->terminarFase();
+    }
+
+    // como la memoización, sin instrumentar: los clones no tienen sitios en
+    // el perfil
+    Especializador especializador(opciones.especializar);
+    bool especializar = opciones.especializar > 0 && !instrumentar;
+    if (especializar) {
+        if (stats) stats->iniciarFase("especializacion");
+        especializador.especializar(program->fundecs->Fundecs, globales);
+        if (stats) stats->terminarFase();
+    }
+
+    // el perfil cuenta cada entrada a la función; con la tabla faltarían
+    int memoizadas = 0;
+    if (opciones.memoizar && !instrumentar) {
+        if (stats) stats->iniciarFase("memoizacion");
+        memoizadas = marcarMemoizables(program->fundecs->Fundecs, globales);
+        if (stats) stats->terminarFase();
+    }
+
+    Optimizer optimizador(opciones.optimizacion);
+    // lo que fija --ipcp solo rinde si después se pliega
+    bool optimizar = (opciones.optimizacion.activa() || especializar) && !instrumentar;
+    if (optimizar) {
+        if (stats) stats->iniciarFase("optimizacion");
+        for (auto f : program->fundecs->Fundecs) optimizador.optimizar(f, globales);
+        if (stats) stats->terminarFase();
+    }
+
+    if (stats) stats->iniciarFase("etiquetado");
+    LabelVisitor labeler;
+    labeler.visit(program);
+    if (stats) stats->terminarFase();
+
+    if (stats) stats->iniciarFase("codegen");
+    GenCodeVisitor codigo(sink);
+    if (instrumentar) codigo.instrumentar(opciones.perfilGenerar);
+    codigo.usarPerfil(perfil);
+    codigo.depurar(opciones.fuenteDepuracion);
+    codigo.generar(program);
+    sink.flush();
+    if (stats) stats->terminarFase();
+
+    if (stats) {
+        NodeCounter nodos(*stats);
+        nodos.visit(program);
+        stats->contar("funciones", program->fundecs->Fundecs.size());
+        if (optimizar) contarOptimizaciones(stats, optimizador);
+        if (perfil) stats->contar("llamadas_expandidas", expandidas);
+        if (opciones.memoizar) stats->contar("funciones_memoizadas", memoizadas);
+        if (especializar) {
+            stats->contar("parametros_propagados", especializador.propagados);
+            stats->contar("funciones_clonadas", especializador.clonadas);
+        }
+    }
+    delete program;
+    return true;
+}
+
+
+bool CompilerContext::compilarPorFuncion(string_view fuente, const CompileOptions& opciones, Emitter& sink) {
+    Stats* stats = opciones.stats;
+    Scanner scanner(fuente);
+    scanner.medir(stats);
+    Parser parser(&scanner);
+    TypeChecker tipos;
+    Optimizer optimizador(opciones.optimizacion);
+    LabelVisitor labeler;
+    GenCodeVisitor codigo(sink);
+    Stats sinUso;
+    NodeCounter nodos(stats ? *stats : sinUso);
+
+    // las firmas de todas las funciones se declaran antes de verificar la
+    // primera, así una llamada a una función definida más abajo ya conoce su
+    // tipo; si el scanner falla, el parser reporta el error
+    if (stats) stats->iniciarFase("parser");
+    vector<Cabecera> cabeceras;
+    bool anticipadas = leerCabeceras(fuente, cabeceras);
+    VarDecList* globales = parser.parseVarDecList();
+    if (stats) stats->terminarFase();
+    codigo.depurar(opciones.fuenteDepuracion);
+    codigo.generarCabecera(globales);
+    tipos.declararGlobales(globales);
+    if (anticipadas) {
+        for (const Cabecera& c : cabeceras) tipos.declararFuncion(c);
+    }
+    if (stats) nodos.visit(globales);
+    delete globales;
+
+    long funciones = 0;
+    while (true) {
+        if (stats) stats->iniciarFase("parser");
+        FunDec* f = parser.parseSiguienteFunDec();
+        if (stats) stats->terminarFase();
+        if (f == nullptr) break;
+        funciones++;
+        // después del primer error se sigue parseando solo para reportar
+        // el resto; la salida ya no sirve
+        if (!parser.hasErrors()) {
+            if (stats) stats->iniciarFase("tipos");
+            if (!anticipadas) tipos.declararFuncion(f);
+            tipos.verificar(f);
+            if (stats) stats->terminarFase();
+        }
+        if (!parser.hasErrors() && !tipos.hayErrores()) {
+            if (opciones.optimizacion.activa()) {
+                if (stats) stats->iniciarFase("optimizacion");
+                optimizador.optimizar(f, codigo.globales());
+                if (stats) stats->terminarFase();
+            }
+
+            if (stats) stats->iniciarFase("etiquetado");
+            labeler.visit(f);
+            if (stats) stats->terminarFase();
+
+            if (stats) stats->iniciarFase("codegen");
+            codigo.visit(f);
+            if (stats) stats->terminarFase();
+        }
+        if (stats) nodos.visit(f);
+        delete f;
+    }
+    if (parser.hasErrors()) {
+        errores = parser.errores();
+        return false;
+    }
+    tipos.terminar();
+    if (tipos.hayErrores()) {
+        errores = tipos.errores();
+        return false;
+    }
+    codigo.generarPie();
+    sink.flush();
+
+    if (stats) {
+        nodos.terminar();
+        stats->contar("funciones", funciones);
+        if (opciones.optimizacion.activa()) contarOptimizaciones(stats, optimizador);
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "emitter.h"
+#include "incremental.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "stats.h"
+using namespace std;
+
+// presupuesto de --ipcp sin =N (y el que usa el servidor)
+const int PRESUPUESTO_ESPECIALIZACION = 1000;
+
+struct CompileOptions {
+    // reutiliza el ensamblador de las funciones que no cambiaron desde la
+    // última compilación incremental hecha con el mismo contexto
+    bool incremental = false;
+    // si no es nulo, recibe tiempos por fase y contadores
+    Stats* stats = nullptr;
+    // etiqueta, genera y libera cada función apenas se parsea, sin
+    // construir el Program; la memoria queda acotada por la función más
+    // grande y la salida empieza a escribirse enseguida. Las pasadas que
+    // necesitan el programa entero lo desactivan.
+    bool porFuncion = true;
+    // pasadas sobre el AST antes del etiquetado (-O1, --unroll=N,
+    // --profile-use)
+    OpcionesOptimizacion optimizacion;
+    // --profile-generate: el programa generado cuenta sus aristas y al
+    // terminar escribe el perfil en esta ruta. Se genera sin optimizar, así
+    // cada contador corresponde a un sitio del fuente.
+    string perfilGenerar;
+    // el perfil numera los sitios sobre el programa entero y ordena sus
+    // funciones: no hay compilación por función ni incremental
+    bool conPerfil() const { return !perfilGenerar.empty() || optimizacion.perfil != nullptr; }
+    // --memoize: tablas de resultados para las funciones puras recursivas
+    // (memoizacion.h). La pureza depende del grafo de llamadas entero, así
+    // que tampoco hay compilación por función ni incremental.
+    bool memoizar = false;
+    // --ipcp[=N]: propaga los argumentos constantes y clona funciones
+    // especializadas en hasta N nodos del AST (especializacion.h); 0 no lo
+    // hace. Necesita todas las llamadas del programa.
+    int especializar = 0;
+    bool programaCompleto() const { return conPerfil() || memoizar || especializar > 0; }
+    // -g: nombre del fuente para las directivas .file/.loc; vacío si no se
+    // emite información de depuración
+    string fuenteDepuracion;
+};
+
+// Punto de entrada del compilador como biblioteca. Un contexto puede
+// compilar muchos fuentes seguidos y conserva entre llamadas sus buffers y
+// la cache incremental. No comparte estado mutable con otros contextos, así
+// que varios hilos pueden compilar a la vez si cada uno usa el suyo.
+class CompilerContext {
+public:
+    // Genera el ensamblador de fuente en sink. Si hay errores de sintaxis
+    // devuelve false, deja los errores en diagnosticos() y lo escrito en
+    // sink queda incompleto.
+    bool compile(string_view fuente, const CompileOptions& opciones, Emitter& sink);
+    const vector<Diagnostico>& diagnosticos() const { return errores; }
+    IncrementalCompiler& cacheIncremental() { return incremental; }
+private:
+    bool compilarCompleto(string_view fuente, const CompileOptions& opciones, Emitter& sink);
+    bool compilarPorFuncion(string_view fuente, const CompileOptions& opciones, Emitter& sink);
+    vector<Diagnostico> errores;
+    IncrementalCompiler incremental;
+};
+
+#endif // COMPILER_H
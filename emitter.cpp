@@ -0,0 +1,139 @@
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include "emitter.h"
+
+using namespace std;
+
+static const char PARES[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static size_t contarLineas(const char* p, size_t n) {
+    size_t total = 0;
+    const char* fin = p + n;
+    while ((p = (const char*) memchr(p, '\n', fin - p)) != nullptr) {
+        total++;
+        p++;
+    }
+    return total;
+}
+
+// Una línea es instrucción si su primera palabra no es una directiva
+// (empieza con '.') ni una etiqueta (termina en ':').
+static size_t contarInstrucciones(const char* p, size_t n) {
+    size_t total = 0;
+    const char* fin = p + n;
+    while (p < fin) {
+        const char* eol = (const char*) memchr(p, '\n', fin - p);
+        if (eol == nullptr) eol = fin;
+        while (p < eol && (*p == ' ' || *p == '\t')) p++;
+        if (p < eol && *p != '.') {
+            const char* q = p;
+            while (q < eol && *q != ' ' && *q != '\t') q++;
+            if (q[-1] != ':') total++;
+        }
+        p = eol + 1;
+    }
+    return total;
+}
+
+Emitter::Emitter(int fd, size_t umbral): fd(fd), umbral(umbral), tam(0) {
+    capacidad = fd >= 0 ? umbral + 4096 : 1 << 16;
+    buffer = (char*) malloc(capacidad);
+    if (buffer == nullptr) {
+        capacidad = 0;
+        error = true;
+    }
+}
+
+Emitter::~Emitter() {
+    flush();
+    free(buffer);
+}
+
+Emitter& Emitter::operator<<(long v) {
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    unsigned long u = v < 0 ? 0UL - (unsigned long) v : (unsigned long) v;
+    while (u >= 100) {
+        unsigned long d = (u % 100) * 2;
+        u /= 100;
+        p -= 2;
+        p[0] = PARES[d];
+        p[1] = PARES[d + 1];
+    }
+    if (u >= 10) {
+        p -= 2;
+        p[0] = PARES[u * 2];
+        p[1] = PARES[u * 2 + 1];
+    } else {
+        *--p = (char) ('0' + u);
+    }
+    if (v < 0) *--p = '-';
+    escribir(p, tmp + sizeof(tmp) - p);
+    return *this;
+}
+
+bool Emitter::crecer(size_t n) {
+    if (fd >= 0 && tam >= umbral) {
+        // solo líneas completas, para que el conteo no parta ninguna
+        const char* ultima = (const char*) memrchr(buffer, '\n', tam);
+        if (ultima != nullptr) volcar(ultima - buffer + 1);
+        if (tam + n <= capacidad) return true;
+    }
+    // después de perder un trozo la salida ya no sirve
+    if (error) return false;
+    size_t nueva = capacidad > 0 ? capacidad * 2 : 1 << 16;
+    while (nueva < tam + n) nueva *= 2;
+    // si realloc falla el bloque viejo sigue siendo válido
+    char* nuevo = (char*) realloc(buffer, nueva);
+    if (nuevo == nullptr) {
+        error = true;
+        return false;
+    }
+    buffer = nuevo;
+    capacidad = nueva;
+    return true;
+}
+
+bool Emitter::flush() {
+    if (fd >= 0 && tam > 0) volcar(tam);
+    return !error;
+}
+
+void Emitter::volcar(size_t n) {
+    if (medido) {
+        lineasEscritas += contarLineas(buffer, n);
+        instruccionesEscritas += contarInstrucciones(buffer, n);
+    }
+    size_t hecho = 0;
+    while (hecho < n) {
+        ssize_t r = ::write(fd, buffer + hecho, n - hecho);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            error = true;
+            break;
+        }
+        hecho += r;
+    }
+    escritos += hecho;
+    memmove(buffer, buffer + n, tam - n);
+    tam -= n;
+}
+
+size_t Emitter::lineas() const {
+    return lineasEscritas + contarLineas(buffer, tam);
+}
+
+size_t Emitter::instrucciones() const {
+    return instruccionesEscritas + contarInstrucciones(buffer, tam);
+}
@@ -0,0 +1,83 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+using namespace std;
+
+// Buffer de salida para el ensamblador generado. Acumula el texto en un
+// bloque de memoria que crece según haga falta y lo escribe con write(2)
+// en trozos grandes (si tiene un descriptor asociado) o al final.
+// Los literales se copian con su longitud conocida en compilación, así que
+// los mnemónicos no pasan por strlen ni por el locale de iostream.
+// Si falla un write o no hay memoria para crecer, lo que sigue se descarta
+// y flush() devuelve false.
+class Emitter {
+public:
+    explicit Emitter(int fd = -1, size_t umbral = 1 << 20);
+    ~Emitter();
+    Emitter(const Emitter&) = delete;
+    Emitter& operator=(const Emitter&) = delete;
+
+    template <size_t N>
+    Emitter& operator<<(const char (&literal)[N]) {
+        escribir(literal, N - 1);
+        return *this;
+    }
+    Emitter& operator<<(string_view s) {
+        escribir(s.data(), s.size());
+        return *this;
+    }
+    Emitter& operator<<(const string& s) {
+        escribir(s.data(), s.size());
+        return *this;
+    }
+    Emitter& operator<<(char c) {
+        if (tam == capacidad && !crecer(1)) return *this;
+        buffer[tam++] = c;
+        return *this;
+    }
+    Emitter& operator<<(long v);
+    Emitter& operator<<(int v) { return *this << (long) v; }
+
+    void escribir(const char* s, size_t n) {
+        if (tam + n > capacidad && !crecer(n)) return;
+        memcpy(buffer + tam, s, n);
+        tam += n;
+    }
+    const char* data() const { return buffer; }
+    size_t size() const { return tam; }
+    string_view vista() const { return string_view(buffer, tam); }
+    void truncar(size_t n) { if (n < tam) tam = n; }
+    // en memoria, el buffer vacío ya no arrastra un error anterior
+    void clear() {
+        tam = 0;
+        if (fd < 0) error = false;
+    }
+
+    bool flush();
+    size_t bytesEscritos() const { return escritos; }
+    // Con medir() cada volcado cuenta sus líneas e instrucciones; sin eso
+    // (sin --stats) no se recorre lo escrito y lineas() e instrucciones()
+    // solo cuentan lo que sigue en el buffer.
+    void medir() { medido = true; }
+    size_t lineas() const;
+    size_t instrucciones() const;
+private:
+    bool crecer(size_t n);
+    void volcar(size_t n);
+    int fd;
+    size_t umbral;
+    char* buffer;
+    size_t tam;
+    size_t capacidad;
+    size_t escritos = 0;
+    size_t lineasEscritas = 0;
+    size_t instruccionesEscritas = 0;
+    bool medido = false;
+    bool error = false;
+};
+
+#endif // EMITTER_H
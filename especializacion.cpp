@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+#include <vector>
+#include "especializacion.h"
+#include "exp.h"
+#include "trace.h"
+
+using namespace std;
+
+// (parámetro, constante) de los argumentos fijos de una llamada, por índice
+typedef vector<pair<int, long>> Firma;
+
+// Variables que el cuerpo asigna, contando las de los for.
+static void anotarAsignadas(Body* b, unordered_set<string>& asignadas) {
+    recorrerSentencias(b, [&](Stm* s) {
+        if (s->kind == ASSIGN_STM) asignadas.insert(static_cast<AssignStatement*>(s)->id);
+        else if (s->kind == FOR_STM) asignadas.insert(static_cast<ForStatement*>(s)->variable);
+    });
+}
+
+// Nodos del AST de un cuerpo: sentencias y expresiones. Es lo que cuesta
+// cada clon contra el presupuesto.
+static long tamano(Body* b) {
+    long nodos = 0;
+    recorrerSentencias(b, [&](Stm*) { nodos++; });
+    recorrerExpresiones(b, [&](Exp*) { nodos++; });
+    return nodos;
+}
+
+static string describir(const FunDec* f, const Firma& firma) {
+    string s;
+    for (auto& [i, v] : firma) s += (s.empty() ? "" : ", ") + f->parametros[i] + "=" + to_string(v);
+    return s;
+}
+
+// Quita de f los parámetros de la firma: cada uno pasa a ser una variable
+// local que empieza con su constante.
+static void fijar(FunDec* f, const Firma& firma) {
+    for (auto it = firma.rbegin(); it != firma.rend(); ++it) {
+        auto [i, valor] = *it;
+        string nombre = f->parametros[i];
+        auto tipo = next(f->tipos.begin(), i);
+        Exp* constante = *tipo == "bool" ? (Exp*) new BoolExp(valor != 0) : (Exp*) new NumberExp((int) valor);
+        VarDec* dec = new VarDec(*tipo, {nombre});
+        dec->linea = f->linea;
+        dec->columna = f->columna;
+        f->cuerpo->vardecs->vardecs.push_front(dec);
+        AssignStatement* a = new AssignStatement(nombre, constante);
+        a->linea = f->linea;
+        a->columna = f->columna;
+        f->cuerpo->slist->stms.push_front(a);
+        f->parametros.erase(f->parametros.begin() + i);
+        f->tipos.erase(tipo);
+    }
+}
+
+static void quitarArgumentos(FCallExp* llamada, const Firma& firma) {
+    for (auto it = firma.rbegin(); it != firma.rend(); ++it) {
+        delete llamada->argumentos[it->first];
+        llamada->argumentos.erase(llamada->argumentos.begin() + it->first);
+    }
+}
+
+void Especializador::especializar(list<FunDec*>& funciones, const unordered_map<string, bool>& globales) {
+    struct Llamada {
+        FCallExp* llamada;
+        FunDec* llamador;
+    };
+    unordered_map<string, FunDec*> porNombre;
+    unordered_map<FunDec*, unordered_set<string>> asignadas;
+    for (auto f : funciones) {
+        porNombre[f->nombre] = f;
+        anotarAsignadas(f->cuerpo, asignadas[f]);
+    }
+    auto recolectar = [&]() {
+        unordered_map<FunDec*, vector<Llamada>> llamadas;
+        for (auto f : funciones) {
+            recorrerLlamadas(f->cuerpo, [&](FCallExp* l) {
+                auto destino = porNombre.find(l->nombre);
+                if (destino != porNombre.end()) llamadas[destino->second].push_back({l, f});
+            });
+        }
+        return llamadas;
+    };
+    // un parámetro con nombre de global se resuelve como la global: no se fija
+    auto fijable = [&](FunDec* f, int i) {
+        return f->nombre != "main" && !globales.count(f->parametros[i]);
+    };
+    // f(..., p, ...) dentro de f pasa el mismo valor que recibió si p no se
+    // reasigna
+    auto pasaDeLargo = [&](const Llamada& l, FunDec* f, int i) {
+        Exp* arg = l.llamada->argumentos[i];
+        return l.llamador == f && arg->kind == IDENTIFIER_EXP
+            && static_cast<IdentifierExp*>(arg)->name == f->parametros[i] && !asignadas[f].count(f->parametros[i]);
+    };
+
+    // 1. parámetros que reciben la misma constante en todas las llamadas
+    auto llamadas = recolectar();
+    for (auto f : funciones) {
+        auto sitios = llamadas.find(f);
+        if (sitios == llamadas.end()) continue;
+        Firma comun;
+        for (int i = 0; i < (int) f->parametros.size(); i++) {
+            if (!fijable(f, i)) continue;
+            bool conocido = false, igual = true;
+            long valor = 0;
+            for (auto& l : sitios->second) {
+                if (pasaDeLargo(l, f, i)) continue;
+                long v;
+                if (!esConstante(l.llamada->argumentos[i], v) || (conocido && v != valor)) {
+                    igual = false;
+                    break;
+                }
+                conocido = true;
+                valor = v;
+            }
+            if (conocido && igual) comun.push_back({i, valor});
+        }
+        if (comun.empty()) continue;
+        TRAZA(TRAZA_INFO, "ipcp: " << f->nombre << " recibe siempre " << describir(f, comun));
+        for (auto& l : sitios->second) quitarArgumentos(l.llamada, comun);
+        fijar(f, comun);
+        propagados += comun.size();
+    }
+
+    // 2. clones para las combinaciones de constantes más repetidas
+    struct Candidato {
+        FunDec* f;
+        Firma firma;
+        int llamadas;
+    };
+    vector<Candidato> candidatos;
+    llamadas = recolectar();
+    for (auto f : funciones) {
+        auto sitios = llamadas.find(f);
+        if (sitios == llamadas.end()) continue;
+        map<Firma, int> firmas;
+        for (auto& l : sitios->second) {
+            Firma firma;
+            for (int i = 0; i < (int) f->parametros.size(); i++) {
+                long v;
+                if (fijable(f, i) && esConstante(l.llamada->argumentos[i], v)) firma.push_back({i, v});
+            }
+            if (!firma.empty()) firmas[firma]++;
+        }
+        for (auto& [firma, n] : firmas) candidatos.push_back({f, firma, n});
+    }
+    stable_sort(candidatos.begin(), candidatos.end(),
+                [](const Candidato& a, const Candidato& b) { return a.llamadas > b.llamadas; });
+
+    struct Clon {
+        FunDec* f;
+        FunDec* base;
+        Firma firma;
+    };
+    vector<Clon> clones;
+    unordered_map<FunDec*, int> numerados;
+    long restante = presupuesto;
+    for (auto& c : candidatos) {
+        long costo = tamano(c.f->cuerpo);
+        if (costo > restante) continue;
+        restante -= costo;
+        FunDec* clon = new FunDec();
+        clon->nombre = c.f->nombre + ".esp" + to_string(++numerados[c.f]);
+        clon->tipo = c.f->tipo;
+        clon->parametros = c.f->parametros;
+        clon->tipos = c.f->tipos;
+        clon->cuerpo = clonar(c.f->cuerpo);
+        clon->linea = c.f->linea;
+        clon->columna = c.f->columna;
+        clon->sitios = c.f->sitios;
+        fijar(clon, c.firma);
+        TRAZA(TRAZA_INFO, "ipcp: " << clon->nombre << " con " << describir(c.f, c.firma) << " ("
+              << c.llamadas << " llamadas, " << costo << " nodos)");
+        funciones.insert(next(find(funciones.begin(), funciones.end(), c.f)), clon);
+        clones.push_back({clon, c.f, c.firma});
+        clonadas++;
+    }
+    if (clones.empty()) return;
+
+    // 3. cada llamada va al clon más específico que coincide con sus
+    // constantes. Dentro de un clon, un parámetro fijado que la función no
+    // reasigna vale su constante en todo el cuerpo.
+    unordered_map<FunDec*, const Clon*> clonDe;
+    for (auto& c : clones) clonDe[c.f] = &c;
+    for (auto f : funciones) {
+        unordered_map<string, long> fijos;
+        auto propio = clonDe.find(f);
+        if (propio != clonDe.end()) {
+            const Clon* c = propio->second;
+            for (auto& [i, v] : c->firma) {
+                const string& p = c->base->parametros[i];
+                if (!asignadas[c->base].count(p)) fijos[p] = v;
+            }
+        }
+        auto valorDe = [&](Exp* arg, long& v) {
+            if (esConstante(arg, v)) return true;
+            if (arg->kind != IDENTIFIER_EXP) return false;
+            auto fijo = fijos.find(static_cast<IdentifierExp*>(arg)->name);
+            if (fijo == fijos.end()) return false;
+            v = fijo->second;
+            return true;
+        };
+        recorrerLlamadas(f->cuerpo, [&](FCallExp* l) {
+            auto destino = porNombre.find(l->nombre);
+            if (destino == porNombre.end()) return;
+            const Clon* mejor = nullptr;
+            for (auto& c : clones) {
+                if (c.base != destino->second || (mejor && mejor->firma.size() >= c.firma.size())) continue;
+                bool coincide = true;
+                for (auto& [i, v] : c.firma) {
+                    long arg;
+                    if (!valorDe(l->argumentos[i], arg) || arg != v) coincide = false;
+                }
+                if (coincide) mejor = &c;
+            }
+            if (!mejor) return;
+            l->nombre = mejor->f->nombre;
+            quitarArgumentos(l, mejor->firma);
+        });
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef ESPECIALIZACION_H
+#define ESPECIALIZACION_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+class FunDec;
+
+// Propagación de constantes entre funciones (--ipcp).
+//
+// Agrupa las llamadas de cada función por los argumentos que son
+// constantes (NumberExp o BoolExp):
+//  - un parámetro que recibe la misma constante en todas las llamadas se
+//    asigna al principio de la función;
+//  - cada otra combinación de constantes, de la más repetida a la menos,
+//    se clona en una versión <f>.esp<k> sin esos parámetros (los declara
+//    como variables con su constante) mientras los clones no pasen de
+//    `presupuesto` nodos del AST. Las llamadas con esas constantes, también
+//    las recursivas que pasan el parámetro sin cambiarlo, van al clon.
+// Después el optimizador pliega lo que dependía de esas constantes. Como
+// necesita todas las llamadas, solo sirve para la compilación del programa
+// entero.
+class Especializador {
+public:
+    explicit Especializador(int presupuesto) : presupuesto(presupuesto) {}
+    void especializar(list<FunDec*>& funciones, const unordered_map<string, bool>& globales);
+    long propagados = 0;   // parámetros con la misma constante en todas las llamadas
+    long clonadas = 0;
+private:
+    int presupuesto;
+};
+
+#endif // ESPECIALIZACION_H
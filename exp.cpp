@@ -1,77 +1,358 @@
-#include <iostream>
-#include "exp.h"
-using namespace std;
-BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp op):left(l),right(r),op(op) {
-    if (op == PLUS_OP || op == MINUS_OP || op == MUL_OP || op == DIV_OP) {
-        type = "int";
-    } else {
-        type = "bool";
-    }
-}
-NumberExp::NumberExp(int v):value(v) {}
-BoolExp::BoolExp(bool v):value(v) {}
-IdentifierExp::IdentifierExp(const string& n):name(n) {}
-Exp::~Exp() {}
-BinaryExp::~BinaryExp() { delete left; delete right; }
-NumberExp::~NumberExp() { }
-BoolExp::~BoolExp() { }
-IdentifierExp::~IdentifierExp() { }
-AssignStatement::AssignStatement(string id, Exp* e): id(id), rhs(e) {}
-AssignStatement::~AssignStatement() {
-    delete rhs;
-}
-PrintStatement::PrintStatement(Exp* e): e(e) {}
-PrintStatement::~PrintStatement() {
-    delete e;
-}
-IfStatement::IfStatement(Exp* c, Body* t, Body* e): condition(c), then(t), els(e) {}
-IfStatement::~IfStatement() {
-    delete condition;
-    delete then;
-    delete els;
-}
-WhileStatement::WhileStatement(Exp* c, Body* t): condition(c), b(t) {}
-WhileStatement::~WhileStatement() {
-    delete condition;
-    delete b;
-}
-VarDec::VarDec(string type, list<string> ids): type(type), vars(ids) {}
-VarDec::~VarDec() {}
-VarDecList::VarDecList(): vardecs() {}
-void VarDecList::add(VarDec* v) {
-    vardecs.push_back(v);
-}
-VarDecList::~VarDecList() {
-    for (auto v: vardecs) {
-        delete v;
-    }
-}
-StatementList::StatementList(): stms() {}
-void StatementList::add(Stm* s) {
-    stms.push_back(s);
-}
-StatementList::~StatementList() {
-    for (auto s: stms) {
-        delete s;
-    }
-}
-Body::Body(VarDecList* v, StatementList* s): vardecs(v), slist(s) {}
-Body::~Body() {
-    delete vardecs;
-    delete slist;
-}
-Stm::~Stm() {}
-string Exp::binopToChar(BinaryOp op) {
-    string  c;
-    switch(op) {
-        case PLUS_OP: c = "+"; break;
-        case MINUS_OP: c = "-"; break;
-        case MUL_OP: c = "*"; break;
-        case DIV_OP: c = "/"; break;
-        case LT_OP: c = "<"; break;
-        case LE_OP: c = "<="; break;
-        case EQ_OP: c = "=="; break;
-        default: c = "$";
-    }
-    return c;
-}
\ No newline at end of file
+#include <iostream>
+#include <vector>
+#include "exp.h"
+using namespace std;
+
+// Los árboles de expresiones y los bloques anidados pueden ser muy
+// profundos (cadenas de 10^6 términos), así que se liberan con una pila
+// explícita: cada nodo entrega sus hijos a la pila antes de destruirse y
+// su destructor ya no tiene nada que recorrer.
+static void destruirExps(vector<Exp*>& pendientes) {
+    while (!pendientes.empty()) {
+        Exp* e = pendientes.back();
+        pendientes.pop_back();
+        if (e->kind == BINARY_EXP) {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            pendientes.push_back(b->left);
+            pendientes.push_back(b->right);
+            b->left = b->right = nullptr;
+        } else if (e->kind == FCALL_EXP) {
+            FCallExp* f = static_cast<FCallExp*>(e);
+            pendientes.insert(pendientes.end(), f->argumentos.begin(), f->argumentos.end());
+            f->argumentos.clear();
+        } else if (e->kind == INDEX_EXP) {
+            IndexExp* x = static_cast<IndexExp*>(e);
+            pendientes.push_back(x->indice);
+            x->indice = nullptr;
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            for (Exp* parte : {x->condicion, x->entonces, x->sino}) {
+                if (parte) pendientes.push_back(parte);
+            }
+            x->condicion = x->entonces = x->sino = nullptr;
+        }
+        delete e;
+    }
+}
+
+static void soltarSentencias(Body* b, vector<Stm*>& pendientes) {
+    if (b == nullptr || b->slist == nullptr) return;
+    pendientes.insert(pendientes.end(), b->slist->stms.begin(), b->slist->stms.end());
+    b->slist->stms.clear();
+}
+BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp op):Exp(BINARY_EXP),left(l),right(r),op(op) {}
+NumberExp::NumberExp(int v):Exp(NUMBER_EXP),value(v) { tipo = TIPO_INT; }
+BoolExp::BoolExp(bool v):Exp(BOOL_EXP),value(v) { tipo = TIPO_BOOL; }
+IdentifierExp::IdentifierExp(const string& n):Exp(IDENTIFIER_EXP),name(n) {}
+IndexExp::IndexExp(const string& n, Exp* i):Exp(INDEX_EXP),nombre(n),indice(i) { tipo = TIPO_INT; }
+IfExp::IfExp(Exp* c, Exp* t, Exp* e):Exp(IF_EXP),condicion(c),entonces(t),sino(e) {}
+Exp::~Exp() {}
+BinaryExp::~BinaryExp() {
+    if (left == nullptr && right == nullptr) return;
+    vector<Exp*> pendientes = {left, right};
+    destruirExps(pendientes);
+}
+FCallExp::~FCallExp() {
+    if (argumentos.empty()) return;
+    vector<Exp*> pendientes(argumentos.begin(), argumentos.end());
+    destruirExps(pendientes);
+}
+IndexExp::~IndexExp() {
+    if (indice == nullptr) return;
+    vector<Exp*> pendientes = {indice};
+    destruirExps(pendientes);
+}
+IfExp::~IfExp() {
+    vector<Exp*> pendientes;
+    for (Exp* parte : {condicion, entonces, sino}) {
+        if (parte) pendientes.push_back(parte);
+    }
+    destruirExps(pendientes);
+}
+NumberExp::~NumberExp() { }
+BoolExp::~BoolExp() { }
+IdentifierExp::~IdentifierExp() { }
+AssignStatement::AssignStatement(string id, Exp* e): Stm(ASSIGN_STM), id(id), rhs(e) {}
+AssignStatement::~AssignStatement() {
+    delete rhs;
+    delete indice;
+}
+PrintStatement::PrintStatement(Exp* e): Stm(PRINT_STM), e(e) {}
+PrintStatement::~PrintStatement() {
+    delete e;
+}
+IfStatement::IfStatement(Exp* c, Body* t, Body* e): Stm(IF_STM), condition(c), then(t), els(e) {}
+IfStatement::~IfStatement() {
+    delete condition;
+    delete then;
+    delete els;
+}
+WhileStatement::WhileStatement(Exp* c, Body* t): Stm(WHILE_STM), condition(c), b(t) {}
+WhileStatement::~WhileStatement() {
+    delete condition;
+    delete b;
+    delete vectorial;
+}
+ForStatement::ForStatement(const string& v, Exp* i, Exp* f, Body* t): Stm(FOR_STM), variable(v), inicio(i), fin(f), b(t) {}
+ForStatement::~ForStatement() {
+    delete inicio;
+    delete fin;
+    delete b;
+}
+VarDec::VarDec(string type, list<string> ids): type(type), vars(ids) {}
+VarDec::~VarDec() {}
+VarDecList::VarDecList(): vardecs() {}
+void VarDecList::add(VarDec* v) {
+    vardecs.push_back(v);
+}
+VarDecList::~VarDecList() {
+    for (auto v: vardecs) {
+        delete v;
+    }
+}
+StatementList::StatementList(): stms() {}
+void StatementList::add(Stm* s) {
+    stms.push_back(s);
+}
+StatementList::~StatementList() {
+    if (stms.empty()) return;
+    vector<Stm*> pendientes(stms.begin(), stms.end());
+    while (!pendientes.empty()) {
+        Stm* s = pendientes.back();
+        pendientes.pop_back();
+        if (s->kind == IF_STM) {
+            IfStatement* i = static_cast<IfStatement*>(s);
+            soltarSentencias(i->then, pendientes);
+            soltarSentencias(i->els, pendientes);
+        } else if (s->kind == WHILE_STM) {
+            soltarSentencias(static_cast<WhileStatement*>(s)->b, pendientes);
+        } else if (s->kind == FOR_STM) {
+            soltarSentencias(static_cast<ForStatement*>(s)->b, pendientes);
+        }
+        delete s;
+    }
+}
+Body::Body(VarDecList* v, StatementList* s): vardecs(v), slist(s) {}
+Body::~Body() {
+    delete vardecs;
+    delete slist;
+}
+Stm::~Stm() {}
+Tipo tipoDeNombre(const string& nombre) {
+    if (nombre == "int") return TIPO_INT;
+    if (nombre == "bool") return TIPO_BOOL;
+    return TIPO_DESCONOCIDO;
+}
+const char* nombreDeTipo(Tipo tipo) {
+    switch (tipo) {
+        case TIPO_INT: return "int";
+        case TIPO_BOOL: return "bool";
+        case TIPO_ARREGLO: return "int[]";
+        default: return "?";
+    }
+}
+string Exp::binopToChar(BinaryOp op) {
+    string  c;
+    switch(op) {
+        case PLUS_OP: c = "+"; break;
+        case MINUS_OP: c = "-"; break;
+        case MUL_OP: c = "*"; break;
+        case DIV_OP: c = "/"; break;
+        case LT_OP: c = "<"; break;
+        case LE_OP: c = "<="; break;
+        case EQ_OP: c = "=="; break;
+        default: c = "$";
+    }
+    return c;
+}
+
+Exp* clonar(const Exp* raiz) {
+    Exp* copia = nullptr;
+    // cada pendiente es un nodo original y el puntero donde va su copia
+    vector<pair<const Exp*, Exp**>> pendientes = {{raiz, &copia}};
+    while (!pendientes.empty()) {
+        auto [e, ranura] = pendientes.back();
+        pendientes.pop_back();
+        switch (e->kind) {
+            case BINARY_EXP: {
+                const BinaryExp* b = static_cast<const BinaryExp*>(e);
+                BinaryExp* c = new BinaryExp(nullptr, nullptr, b->op);
+                c->tipo = b->tipo;
+                *ranura = c;
+                pendientes.push_back({b->left, &c->left});
+                pendientes.push_back({b->right, &c->right});
+                break;
+            }
+            case NUMBER_EXP:
+                *ranura = new NumberExp(static_cast<const NumberExp*>(e)->value); break;
+            case BOOL_EXP:
+                *ranura = new BoolExp(static_cast<const BoolExp*>(e)->value != 0); break;
+            case IDENTIFIER_EXP:
+                *ranura = new IdentifierExp(static_cast<const IdentifierExp*>(e)->name);
+                (*ranura)->tipo = e->tipo;
+                break;
+            case FCALL_EXP: {
+                const FCallExp* f = static_cast<const FCallExp*>(e);
+                FCallExp* c = new FCallExp();
+                c->nombre = f->nombre;
+                c->tipo = f->tipo;
+                c->sitio = f->sitio;
+                c->argumentos.resize(f->argumentos.size());
+                *ranura = c;
+                for (size_t i = 0; i < f->argumentos.size(); i++) {
+                    pendientes.push_back({f->argumentos[i], &c->argumentos[i]});
+                }
+                break;
+            }
+            case INDEX_EXP: {
+                const IndexExp* x = static_cast<const IndexExp*>(e);
+                IndexExp* c = new IndexExp(x->nombre, nullptr);
+                *ranura = c;
+                pendientes.push_back({x->indice, &c->indice});
+                break;
+            }
+            case IF_EXP: {
+                const IfExp* x = static_cast<const IfExp*>(e);
+                IfExp* c = new IfExp(nullptr, nullptr, nullptr);
+                c->tipo = x->tipo;
+                *ranura = c;
+                pendientes.push_back({x->condicion, &c->condicion});
+                pendientes.push_back({x->entonces, &c->entonces});
+                pendientes.push_back({x->sino, &c->sino});
+                break;
+            }
+        }
+    }
+    return copia;
+}
+
+static Stm* copiarSentencia(const Stm* s);
+
+Stm* clonar(const Stm* s) {
+    Stm* c = copiarSentencia(s);
+    c->linea = s->linea;
+    c->columna = s->columna;
+    return c;
+}
+
+static Stm* copiarSentencia(const Stm* s) {
+    switch (s->kind) {
+        case ASSIGN_STM: {
+            const AssignStatement* a = static_cast<const AssignStatement*>(s);
+            AssignStatement* c = new AssignStatement(a->id, clonar(a->rhs));
+            c->indice = a->indice ? clonar(a->indice) : nullptr;
+            return c;
+        }
+        case PRINT_STM:
+            return new PrintStatement(clonar(static_cast<const PrintStatement*>(s)->e));
+        case IF_STM: {
+            const IfStatement* i = static_cast<const IfStatement*>(s);
+            IfStatement* c = new IfStatement(clonar(i->condition), clonar(i->then), i->els ? clonar(i->els) : nullptr);
+            c->sitio = i->sitio;
+            return c;
+        }
+        case WHILE_STM: {
+            const WhileStatement* w = static_cast<const WhileStatement*>(s);
+            WhileStatement* c = new WhileStatement(clonar(w->condition), clonar(w->b));
+            c->sitio = w->sitio;
+            c->vectorial = w->vectorial ? new BucleVectorial(*w->vectorial) : nullptr;
+            return c;
+        }
+        case FOR_STM: {
+            const ForStatement* f = static_cast<const ForStatement*>(s);
+            return new ForStatement(f->variable, clonar(f->inicio), clonar(f->fin), clonar(f->b));
+        }
+        case RETURN_STM: {
+            ReturnStatement* r = new ReturnStatement();
+            const Exp* e = static_cast<const ReturnStatement*>(s)->e;
+            r->e = e ? clonar(e) : nullptr;
+            return r;
+        }
+    }
+    return nullptr;
+}
+
+Body* clonar(const Body* b) {
+    VarDecList* vardecs = new VarDecList();
+    for (auto dec : b->vardecs->vardecs) {
+        VarDec* copia = new VarDec(dec->type, dec->vars);
+        copia->longitud = dec->longitud;
+        copia->linea = dec->linea;
+        copia->columna = dec->columna;
+        vardecs->add(copia);
+    }
+    StatementList* stms = new StatementList();
+    for (auto s : b->slist->stms) stms->add(clonar(s));
+    return new Body(vardecs, stms);
+}
+
+void apilarHijos(Exp* e, vector<Exp*>& pila) {
+    if (e->kind == BINARY_EXP) {
+        BinaryExp* b = static_cast<BinaryExp*>(e);
+        pila.push_back(b->right);
+        pila.push_back(b->left);
+    } else if (e->kind == FCALL_EXP) {
+        auto& args = static_cast<FCallExp*>(e)->argumentos;
+        pila.insert(pila.end(), args.rbegin(), args.rend());
+    } else if (e->kind == INDEX_EXP) {
+        pila.push_back(static_cast<IndexExp*>(e)->indice);
+    } else if (e->kind == IF_EXP) {
+        IfExp* x = static_cast<IfExp*>(e);
+        pila.push_back(x->sino);
+        pila.push_back(x->entonces);
+        pila.push_back(x->condicion);
+    }
+}
+
+void apilarSentencias(Body* b, vector<Stm*>& pila) {
+    if (b == nullptr || b->slist == nullptr) return;
+    pila.insert(pila.end(), b->slist->stms.rbegin(), b->slist->stms.rend());
+}
+
+void apilarBloques(Stm* s, vector<Stm*>& pila) {
+    if (s->kind == IF_STM) {
+        IfStatement* i = static_cast<IfStatement*>(s);
+        apilarSentencias(i->els, pila);
+        apilarSentencias(i->then, pila);
+    } else if (s->kind == WHILE_STM) {
+        apilarSentencias(static_cast<WhileStatement*>(s)->b, pila);
+    } else if (s->kind == FOR_STM) {
+        apilarSentencias(static_cast<ForStatement*>(s)->b, pila);
+    }
+}
+
+void expresionesDe(Stm* s, vector<Exp*>& exps) {
+    switch (s->kind) {
+        case ASSIGN_STM: {
+            AssignStatement* a = static_cast<AssignStatement*>(s);
+            if (a->indice) exps.push_back(a->indice);
+            exps.push_back(a->rhs);
+            break;
+        }
+        case PRINT_STM:
+            exps.push_back(static_cast<PrintStatement*>(s)->e);
+            break;
+        case RETURN_STM:
+            if (static_cast<ReturnStatement*>(s)->e) exps.push_back(static_cast<ReturnStatement*>(s)->e);
+            break;
+        case IF_STM:
+            exps.push_back(static_cast<IfStatement*>(s)->condition);
+            break;
+        case WHILE_STM:
+            exps.push_back(static_cast<WhileStatement*>(s)->condition);
+            break;
+        case FOR_STM: {
+            ForStatement* f = static_cast<ForStatement*>(s);
+            exps.push_back(f->inicio);
+            exps.push_back(f->fin);
+            break;
+        }
+    }
+}
+
+bool esConstante(Exp* e, long& valor) {
+    if (e->kind == NUMBER_EXP) valor = static_cast<NumberExp*>(e)->value;
+    else if (e->kind == BOOL_EXP) valor = static_cast<BoolExp*>(e)->value;
+    else return false;
+    return true;
+}
@@ -1,183 +1,346 @@
-#ifndef EXP_H
-#define EXP_H
-
-#include <string>
-#include <unordered_map>
-#include <list>
-#include "visitor.h"
-using namespace std;
-enum BinaryOp { PLUS_OP, MINUS_OP, MUL_OP, DIV_OP,LT_OP, LE_OP, EQ_OP };
-
-class Body;
-
-class Exp {
-public:
-    int etiqueta = -1;
-    virtual int  accept(Visitor* visitor) = 0;
-    virtual ~Exp() = 0;
-    static string binopToChar(BinaryOp op);
-};
-
-class BinaryExp : public Exp {
-public:
-    Exp *left, *right;
-    string type;
-    BinaryOp op;
-    BinaryExp(Exp* l, Exp* r, BinaryOp op);
-    int accept(Visitor* visitor);
-    ~BinaryExp();
-};
-
-class NumberExp : public Exp {
-public:
-    int value;
-    NumberExp(int v);
-    int accept(Visitor* visitor);
-    ~NumberExp();
-};
-
-class BoolExp : public Exp {
-public:
-    int value;
-    BoolExp(bool v);
-    int accept(Visitor* visitor);
-    ~BoolExp();
-};
-
-class IdentifierExp : public Exp {
-public:
-
-    std::string name;
-    IdentifierExp(const std::string& n);
-    int accept(Visitor* visitor);
-    ~IdentifierExp();
-};
-
-class Stm {
-public:
-    virtual int accept(Visitor* visitor) = 0;
-    virtual ~Stm() = 0;
-};
-
-class AssignStatement : public Stm {
-public:
-    std::string id;
-    Exp* rhs;
-    AssignStatement(std::string id, Exp* e);
-    int accept(Visitor* visitor);
-    ~AssignStatement();
-};
-
-class PrintStatement : public Stm {
-public:
-    Exp* e;
-    PrintStatement(Exp* e);
-    int accept(Visitor* visitor);
-    ~PrintStatement();
-};
-
-class IfStatement : public Stm {
-public:
-    Exp* condition;
-    Body* then;
-    Body* els;
-    IfStatement(Exp* condition, Body* then, Body* els);
-    int accept(Visitor* visitor);
-    ~IfStatement();
-};
-
-class WhileStatement : public Stm {
-public:
-    Exp* condition;
-    Body* b;
-    WhileStatement(Exp* condition, Body* b);
-    int accept(Visitor* visitor);
-    ~WhileStatement();
-};
-
-class VarDec {
-public:
-    string type;
-    list<string> vars;
-    VarDec(string type, list<string> vars);
-    int accept(Visitor* visitor);
-    ~VarDec();
-};
-
-class VarDecList{
-public:
-    list<VarDec*> vardecs;
-    VarDecList();
-    void add(VarDec* vardec);
-    int accept(Visitor* visitor);
-    ~VarDecList();
-};
-
-class StatementList {
-public:
-    list<Stm*> stms;
-    StatementList();
-    void add(Stm* stm);
-    int accept(Visitor* visitor);
-    ~StatementList();
-};
-
-class Body{
-public:
-    VarDecList* vardecs;
-    StatementList* slist;
-    int accept(Visitor* visitor);
-    Body(VarDecList* vardecs, StatementList* stms);
-    ~Body();
-};
-
-class FunDec {
-public:
-    string nombre;
-    string tipo;
-    vector<string> parametros;
-    list<string> tipos;
-    Body* cuerpo;
-    FunDec(){};
-    ~FunDec(){};
-    int accept(Visitor* visitor);
-};
-
-class FCallExp : public Exp {
-public:
-    string nombre;
-    vector<Exp*> argumentos;
-    FCallExp(){};
-    ~FCallExp(){};
-    int accept(Visitor* visitor);
-};
-
-class FunDecList{
-public:
-    list<FunDec*> Fundecs;
-    void add(FunDec* fundec) {
-        Fundecs.push_back(fundec);
-    };
-    int accept(Visitor* visitor);
-    FunDecList(){};
-    ~FunDecList(){};
-};
-
-class ReturnStatement: public Stm {
-public:
-    Exp* e;
-    ReturnStatement(){};
-    ~ReturnStatement(){};
-    int accept(Visitor* visitor);
-};
-
-class Program {
-public:
-    VarDecList* vardecs;
-    FunDecList* fundecs;
-    Program(){};
-    ~Program(){};
-    int accept(Visitor* visitor); 
-};
-
+#ifndef EXP_H
+#define EXP_H
+
+#include <string>
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include "visitor.h"
+using namespace std;
+enum BinaryOp { PLUS_OP, MINUS_OP, MUL_OP, DIV_OP,LT_OP, LE_OP, EQ_OP };
+// Clase concreta de cada expresión. Los recorridos con pila explícita la
+// usan para bajar a los hijos sin pasar por accept().
+enum ExpKind { BINARY_EXP, NUMBER_EXP, BOOL_EXP, IDENTIFIER_EXP, FCALL_EXP, INDEX_EXP, IF_EXP };
+enum StmKind { ASSIGN_STM, PRINT_STM, IF_STM, WHILE_STM, RETURN_STM, FOR_STM };
+// Tipo de una expresión, variable o función; lo resuelve TypeChecker. Un
+// arreglo (de int) solo es el tipo de una variable: no hay valores arreglo.
+enum Tipo : unsigned char { TIPO_DESCONOCIDO, TIPO_INT, TIPO_BOOL, TIPO_ARREGLO };
+Tipo tipoDeNombre(const string& nombre);
+const char* nombreDeTipo(Tipo tipo);
+
+class Body;
+
+class Exp {
+public:
+    const ExpKind kind;
+    Tipo tipo = TIPO_DESCONOCIDO;
+    int etiqueta = -1;
+    // el subárbol se puede evaluar aunque no haga falta: sin llamadas, sin
+    // divisiones (idivq por cero termina el programa) y sin elementos de
+    // arreglos (el índice puede estar fuera de rango justo cuando una ifexp
+    // lo descarta). Lo calcula LabelVisitor junto con la etiqueta.
+    bool sinEfectos = true;
+    Exp(ExpKind kind) : kind(kind) {}
+    // sin subexpresiones: los recorridos iterativos la visitan directamente
+    bool esHoja() const { return kind != BINARY_EXP && kind != FCALL_EXP && kind != INDEX_EXP && kind != IF_EXP; }
+    virtual int  accept(Visitor* visitor) = 0;
+    virtual ~Exp() = 0;
+    static string binopToChar(BinaryOp op);
+};
+
+class BinaryExp : public Exp {
+public:
+    Exp *left, *right;
+    BinaryOp op;
+    BinaryExp(Exp* l, Exp* r, BinaryOp op);
+    int accept(Visitor* visitor);
+    ~BinaryExp();
+};
+
+class NumberExp : public Exp {
+public:
+    int value;
+    NumberExp(int v);
+    int accept(Visitor* visitor);
+    ~NumberExp();
+};
+
+class BoolExp : public Exp {
+public:
+    int value;
+    BoolExp(bool v);
+    int accept(Visitor* visitor);
+    ~BoolExp();
+};
+
+class IdentifierExp : public Exp {
+public:
+
+    std::string name;
+    IdentifierExp(const std::string& n);
+    int accept(Visitor* visitor);
+    ~IdentifierExp();
+};
+
+// a[indice]: elemento de un arreglo de int. Los elementos ocupan 8 bytes
+// contiguos y no se verifica el rango del índice.
+class IndexExp : public Exp {
+public:
+    string nombre;
+    Exp* indice;
+    IndexExp(const string& nombre, Exp* indice);
+    int accept(Visitor* visitor);
+    ~IndexExp();
+};
+
+// ifexp(condicion, entonces, sino): entonces si la condición (bool) es
+// verdadera, sino si no. Solo se evalúa una de las dos ramas, salvo que
+// ninguna pueda fallar ni tenga efectos; entonces GenCodeVisitor calcula
+// ambas y elige sin saltar.
+class IfExp : public Exp {
+public:
+    Exp* condicion;
+    Exp* entonces;
+    Exp* sino;
+    // condición y ramas se pueden evaluar siempre, en cualquier orden, y
+    // elegir con cmov (LabelVisitor)
+    bool cmov = false;
+    IfExp(Exp* condicion, Exp* entonces, Exp* sino);
+    int accept(Visitor* visitor);
+    ~IfExp();
+};
+
+class Stm {
+public:
+    const StmKind kind;
+    // posición del primer token de la sentencia
+    int linea = 0, columna = 0;
+    Stm(StmKind kind) : kind(kind) {}
+    virtual int accept(Visitor* visitor) = 0;
+    virtual ~Stm() = 0;
+};
+
+class AssignStatement : public Stm {
+public:
+    std::string id;
+    Exp* rhs;
+    // id[indice] = rhs; nullptr si se asigna una variable
+    Exp* indice = nullptr;
+    AssignStatement(std::string id, Exp* e);
+    int accept(Visitor* visitor);
+    ~AssignStatement();
+};
+
+class PrintStatement : public Stm {
+public:
+    Exp* e;
+    PrintStatement(Exp* e);
+    int accept(Visitor* visitor);
+    ~PrintStatement();
+};
+
+class IfStatement : public Stm {
+public:
+    Exp* condition;
+    Body* then;
+    Body* els;
+    // sitio del perfil (perfil.h); -1 si no se numeró
+    int sitio = -1;
+    IfStatement(Exp* condition, Body* then, Body* els);
+    int accept(Visitor* visitor);
+    ~IfStatement();
+};
+
+// Un while contado que el optimizador puede recorrer con instrucciones
+// empaquetadas: cada vuelta vectorial procesa `ancho` valores de i a la
+// vez y el while original queda como epílogo escalar para las que sobran.
+// Las dos formas, con i el índice del bucle:
+//   destino[i] = t0 ± t1 ± ...        (elemento a elemento)
+//   acumulador = acumulador ± t1 ± ...  (reducción)
+// donde cada término es a[i], una variable que no cambia en el bucle o
+// una constante.
+struct BucleVectorial {
+    struct Termino {
+        enum Clase { ELEMENTO, VARIABLE, CONSTANTE } clase;
+        string nombre;   // arreglo o variable
+        int valor;       // constante
+        bool resta;
+    };
+    int ancho;           // elementos de 64 bits por vector: 2 (SSE2) o 4 (AVX2)
+    string variable;     // i
+    string destino;      // vacío en una reducción
+    string acumulador;   // vacío elemento a elemento
+    vector<Termino> terminos;
+};
+
+class WhileStatement : public Stm {
+public:
+    Exp* condition;
+    Body* b;
+    int sitio = -1;
+    // lo deja el optimizador; nullptr si el bucle no se vectoriza
+    BucleVectorial* vectorial = nullptr;
+    WhileStatement(Exp* condition, Body* b);
+    int accept(Visitor* visitor);
+    ~WhileStatement();
+};
+
+// for variable = inicio, fin do b endfor: variable toma inicio, fin se
+// evalúa una sola vez después y el cuerpo corre mientras variable <= fin,
+// sumando 1 al final de cada vuelta. El cuerpo no asigna la variable.
+class ForStatement : public Stm {
+public:
+    string variable;
+    Exp* inicio;
+    Exp* fin;
+    Body* b;
+    ForStatement(const string& variable, Exp* inicio, Exp* fin, Body* b);
+    int accept(Visitor* visitor);
+    ~ForStatement();
+};
+
+class VarDec {
+public:
+    string type;
+    list<string> vars;
+    // var int[N] a, b: elementos de cada arreglo; 0 si son variables
+    int longitud = 0;
+    int linea = 0, columna = 0;
+    VarDec(string type, list<string> vars);
+    int accept(Visitor* visitor);
+    ~VarDec();
+};
+
+class VarDecList{
+public:
+    list<VarDec*> vardecs;
+    VarDecList();
+    void add(VarDec* vardec);
+    int accept(Visitor* visitor);
+    ~VarDecList();
+};
+
+class StatementList {
+public:
+    list<Stm*> stms;
+    StatementList();
+    void add(Stm* stm);
+    int accept(Visitor* visitor);
+    ~StatementList();
+};
+
+class Body{
+public:
+    VarDecList* vardecs;
+    StatementList* slist;
+    int accept(Visitor* visitor);
+    Body(VarDecList* vardecs, StatementList* stms);
+    ~Body();
+};
+
+class FunDec {
+public:
+    string nombre;
+    string tipo;
+    vector<string> parametros;
+    list<string> tipos;
+    Body* cuerpo = nullptr;
+    int linea = 0, columna = 0;
+    // sitios del perfil numerados en la función (perfil.h)
+    int sitios = 0;
+    // --memoize: pura y recursiva, con una tabla de resultados (memoizacion.h)
+    bool memoizar = false;
+    FunDec(){};
+    ~FunDec(){ delete cuerpo; };
+    int accept(Visitor* visitor);
+};
+
+class FCallExp : public Exp {
+public:
+    string nombre;
+    vector<Exp*> argumentos;
+    int sitio = -1;
+    FCallExp() : Exp(FCALL_EXP) {};
+    ~FCallExp();
+    int accept(Visitor* visitor);
+};
+
+class FunDecList{
+public:
+    list<FunDec*> Fundecs;
+    void add(FunDec* fundec) {
+        Fundecs.push_back(fundec);
+    };
+    int accept(Visitor* visitor);
+    FunDecList(){};
+    ~FunDecList(){ for (auto f : Fundecs) delete f; };
+};
+
+class ReturnStatement: public Stm {
+public:
+    Exp* e = nullptr;
+    ReturnStatement() : Stm(RETURN_STM) {};
+    ~ReturnStatement(){ delete e; };
+    int accept(Visitor* visitor);
+};
+
+class Program {
+public:
+    VarDecList* vardecs;
+    FunDecList* fundecs;
+    Program(){};
+    ~Program(){ delete vardecs; delete fundecs; };
+    int accept(Visitor* visitor); 
+};
+
+// Copias profundas para las pasadas que duplican código. Las expresiones
+// se copian sin recursión, igual que se destruyen.
+Exp* clonar(const Exp* e);
+Stm* clonar(const Stm* s);
+Body* clonar(const Body* b);
+
+// Recorridos para las pasadas que solo miran el árbol, sin recursión.
+// Apilan en orden inverso: al desapilar salen de izquierda a derecha.
+void apilarHijos(Exp* e, vector<Exp*>& pila);
+void apilarSentencias(Body* b, vector<Stm*>& pila);
+// then y else de un if, cuerpo de un while o de un for
+void apilarBloques(Stm* s, vector<Stm*>& pila);
+// Expresiones de la propia sentencia, sin las de sus bloques, en orden.
+void expresionesDe(Stm* s, vector<Exp*>& exps);
+// Literal int o bool; valor queda con su valor.
+bool esConstante(Exp* e, long& valor);
+
+// Expresión en preorden.
+template <typename F>
+void recorrer(Exp* raiz, F visitar) {
+    vector<Exp*> pendientes = {raiz};
+    while (!pendientes.empty()) {
+        Exp* e = pendientes.back();
+        pendientes.pop_back();
+        visitar(e);
+        apilarHijos(e, pendientes);
+    }
+}
+
+// Sentencias de un cuerpo en preorden, con las de sus bloques anidados.
+template <typename F>
+void recorrerSentencias(Body* b, F visitar) {
+    vector<Stm*> pendientes;
+    apilarSentencias(b, pendientes);
+    while (!pendientes.empty()) {
+        Stm* s = pendientes.back();
+        pendientes.pop_back();
+        visitar(s);
+        apilarBloques(s, pendientes);
+    }
+}
+
+// Todas las expresiones de un cuerpo, sentencia por sentencia.
+template <typename F>
+void recorrerExpresiones(Body* b, F visitar) {
+    vector<Exp*> exps;
+    recorrerSentencias(b, [&](Stm* s) {
+        exps.clear();
+        expresionesDe(s, exps);
+        for (Exp* e : exps) recorrer(e, visitar);
+    });
+}
+
+template <typename F>
+void recorrerLlamadas(Body* b, F visitar) {
+    recorrerExpresiones(b, [&](Exp* e) {
+        if (e->kind == FCALL_EXP) visitar(static_cast<FCallExp*>(e));
+    });
+}
+
 #endif // EXP_H
\ No newline at end of file
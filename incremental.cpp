@@ -0,0 +1,232 @@
+#include <iostream>
+#include <fstream>
+#include "token.h"
+#include "scanner.h"
+#include "parser.h"
+#include "visitor.h"
+#include "labelvisitor.h"
+#include "typechecker.h"
+#include "incremental.h"
+
+using namespace std;
+
+// cambia cuando el código de una función guardada ya no sirve con el pie
+// actual (2: print llama a lab20_imprimir)
+static const char* CACHE_MAGIC = "LAB20CACHE 2";
+
+static uint64_t mezclar(uint64_t h, string_view texto) {
+    for (unsigned char c : texto) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= 0xff;
+    h *= 1099511628211ULL;
+    return h;
+}
+
+static uint64_t mezclar(uint64_t h, const Token* tok) {
+    // FNV-1a sobre el tipo y el texto de cada token
+    h ^= (uint64_t) tok->type;
+    h *= 1099511628211ULL;
+    return mezclar(h, tok->text);
+}
+
+bool IncrementalCompiler::cargarCache(const string& ruta) {
+    cache.clear();
+    ifstream in(ruta, ios::binary);
+    if (!in.is_open()) return false;
+    string magic;
+    if (!getline(in, magic) || magic != CACHE_MAGIC) return false;
+    uint64_t huella;
+    size_t len;
+    while (in >> hex >> huella >> dec >> len) {
+        in.get();
+        string codigo(len, '\0');
+        if (!in.read(&codigo[0], len)) {
+            cache.clear();
+            return false;
+        }
+        cache[huella] = codigo;
+    }
+    return true;
+}
+
+bool IncrementalCompiler::guardarCache(const string& ruta) const {
+    ofstream out(ruta, ios::binary);
+    if (!out.is_open()) return false;
+    out << CACHE_MAGIC << '\n';
+    for (auto& [huella, codigo] : cache) {
+        out << hex << huella << dec << ' ' << codigo.size() << '\n';
+        out.write(codigo.data(), codigo.size());
+    }
+    return out.good();
+}
+
+// Con posiciones la huella incluye la línea y columna de cada token: el
+// código con .loc cambia aunque solo se muevan líneas.
+bool IncrementalCompiler::dividir(string_view input, uint64_t semilla, bool posiciones, int& finGlobales,
+                                  vector<Tramo>& tramos) {
+    Scanner scanner(input);
+    uint64_t huellaGlobal = 14695981039346656037ULL ^ semilla;
+    uint64_t h = 0;
+    bool dentro = false;
+    // posición del token dentro de la cabecera de la función; -1 pasada la ')'
+    int cabecera = -1;
+    finGlobales = (int) input.size();
+    Token* tok;
+    while ((tok = scanner.nextToken())->type != Token::END) {
+        if (tok->type == Token::ERR) {
+            delete tok;
+            return false;
+        }
+        if (!dentro && tok->type == Token::FUN) {
+            if (tramos.empty()) finGlobales = scanner.tokenStart();
+            dentro = true;
+            h = huellaGlobal;
+            tramos.push_back({scanner.tokenStart(), 0, 0, {"", "", {}, tok->linea, tok->columna}});
+            cabecera = 0;
+        }
+        if (dentro) {
+            h = mezclar(h, tok);
+            if (posiciones) h = mezclar(h, to_string(tok->linea) + ':' + to_string(tok->columna));
+            leerCabecera(tok, cabecera, tramos.back().firma);
+            if (tok->type == Token::ENDFUN) {
+                tramos.back().last = scanner.tokenEnd();
+                tramos.back().huella = h;
+                dentro = false;
+            }
+        } else if (!tramos.empty()) {
+            // tokens sueltos entre funciones: no se puede dividir
+            delete tok;
+            return false;
+        } else {
+            huellaGlobal = mezclar(huellaGlobal, tok);
+        }
+        delete tok;
+    }
+    delete tok;
+    if (dentro) return false;
+    // cambiar la firma de una función obliga a verificar de nuevo las
+    // que la llaman
+    uint64_t firmas = 14695981039346656037ULL;
+    for (const Tramo& t : tramos) {
+        firmas = mezclar(mezclar(firmas, t.firma.retorno), t.firma.nombre);
+        for (auto& p : t.firma.parametros) firmas = mezclar(firmas, p);
+    }
+    for (Tramo& t : tramos) t.huella = (t.huella ^ firmas) * 1099511628211ULL;
+    return true;
+}
+
+bool IncrementalCompiler::compilarCompleto(string_view input, Emitter& out, const OpcionesOptimizacion& optimizacion,
+                                           const string& fuenteDepuracion) {
+    Scanner scanner(input);
+    Parser parser(&scanner);
+    Program* program = parser.parseProgram();
+    if (parser.hasErrors()) {
+        diagnosticos = parser.errores();
+        delete program;
+        return false;
+    }
+    TypeChecker tipos;
+    tipos.declararGlobales(program->vardecs);
+    for (auto f : program->fundecs->Fundecs) tipos.declararFuncion(f);
+    for (auto f : program->fundecs->Fundecs) tipos.verificar(f);
+    if (tipos.hayErrores()) {
+        diagnosticos = tipos.errores();
+        delete program;
+        return false;
+    }
+    if (optimizacion.activa()) {
+        unordered_map<string, bool> globales;
+        for (auto dec : program->vardecs->vardecs) {
+            for (auto& v : dec->vars) globales[v] = true;
+        }
+        Optimizer optimizador(optimizacion);
+        for (auto f : program->fundecs->Fundecs) optimizador.optimizar(f, globales);
+    }
+    LabelVisitor labeler;
+    labeler.visit(program);
+    GenCodeVisitor codigo(out);
+    codigo.depurar(fuenteDepuracion);
+    codigo.generar(program);
+    cache.clear();
+    reutilizadas = 0;
+    regeneradas = (int) program->fundecs->Fundecs.size();
+    delete program;
+    return true;
+}
+
+bool IncrementalCompiler::compilar(string_view input, Emitter& out, const OpcionesOptimizacion& optimizacion,
+                                   const string& fuenteDepuracion) {
+    int finGlobales;
+    vector<Tramo> tramos;
+    diagnosticos.clear();
+    // las opciones entran en la huella: el mismo fuente optimizado de otra
+    // forma es otra entrada de la cache
+    if (!dividir(input, optimizacion.huella(), !fuenteDepuracion.empty(), finGlobales, tramos)) {
+        return compilarCompleto(input, out, optimizacion, fuenteDepuracion);
+    }
+
+    string_view textoGlobales = input.substr(0, finGlobales);
+    Scanner scannerGlobales(textoGlobales);
+    Parser parserGlobales(&scannerGlobales);
+    VarDecList* globales = parserGlobales.parseVarDecList();
+    if (parserGlobales.hasErrors() || scannerGlobales.tokenStart() < (int) textoGlobales.size()) {
+        // algo distinto de declaraciones antes de la primera función
+        delete globales;
+        return compilarCompleto(input, out, optimizacion, fuenteDepuracion);
+    }
+
+    GenCodeVisitor codigo(out);
+    codigo.depurar(fuenteDepuracion);
+    codigo.generarCabecera(globales);
+    // todas las firmas se declaran antes de verificar las funciones
+    // regeneradas; las reutilizadas ya se verificaron con las mismas
+    TypeChecker tipos;
+    tipos.declararGlobales(globales);
+    for (const Tramo& t : tramos) tipos.declararFuncion(t.firma);
+    delete globales;
+
+    unordered_map<uint64_t, string> usadas;
+    reutilizadas = 0;
+    regeneradas = 0;
+    for (const Tramo& t : tramos) {
+        auto it = cache.find(t.huella);
+        if (it != cache.end()) {
+            out << it->second;
+            usadas[t.huella] = it->second;
+            reutilizadas++;
+            continue;
+        }
+        Scanner scanner(input.substr(t.first, t.last - t.first), t.firma.linea, t.firma.columna);
+        Parser parser(&scanner);
+        FunDec* f = parser.parseFunDec();
+        if (parser.hasErrors()) {
+            diagnosticos.insert(diagnosticos.end(), parser.errores().begin(), parser.errores().end());
+            delete f;
+            continue;
+        }
+        if (!tipos.verificar(f) || tipos.hayErrores()) {
+            delete f;
+            continue;
+        }
+        if (optimizacion.activa()) Optimizer(optimizacion).optimizar(f, codigo.globales());
+        LabelVisitor labeler;
+        labeler.visit(f);
+        funcion.clear();
+        GenCodeVisitor gen(funcion);
+        gen.usarGlobales(codigo.globales());
+        gen.depurar(fuenteDepuracion);
+        f->accept(&gen);
+        delete f;
+        out << funcion.vista();
+        usadas[t.huella] = string(funcion.vista());
+        regeneradas++;
+    }
+    tipos.terminar();
+    diagnosticos.insert(diagnosticos.end(), tipos.errores().begin(), tipos.errores().end());
+    if (!diagnosticos.empty()) return false;
+    codigo.generarPie();
+    cache.swap(usadas);
+    return true;
+}
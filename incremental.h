@@ -0,0 +1,43 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "emitter.h"
+#include "optimizer.h"
+#include "parser.h"
+using namespace std;
+
+// Compilación incremental por función: cada FunDec se identifica por la
+// huella de sus tokens junto con la firma de las variables globales y las
+// firmas de todas las funciones, de las que depende su verificación de
+// tipos. Las funciones cuya huella ya está en la cache reutilizan su
+// ensamblador; solo las editadas se vuelven a parsear y generar.
+class IncrementalCompiler {
+public:
+    bool cargarCache(const string& ruta);
+    bool guardarCache(const string& ruta) const;
+    // con fuenteDepuracion no vacío se emiten .file/.loc (-g)
+    bool compilar(string_view input, Emitter& out, const OpcionesOptimizacion& optimizacion = OpcionesOptimizacion(),
+                  const string& fuenteDepuracion = "");
+    int reutilizadas = 0;
+    int regeneradas = 0;
+    vector<Diagnostico> diagnosticos;
+private:
+    struct Tramo {
+        int first, last;
+        uint64_t huella;
+        // firma y posición del 'fun'
+        Cabecera firma;
+    };
+    bool dividir(string_view input, uint64_t semilla, bool posiciones, int& finGlobales, vector<Tramo>& tramos);
+    bool compilarCompleto(string_view input, Emitter& out, const OpcionesOptimizacion& optimizacion,
+                          const string& fuenteDepuracion);
+    unordered_map<uint64_t, string> cache;
+    Emitter funcion;
+};
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,183 @@
+#include <vector>
+#include "inliner.h"
+#include "trace.h"
+
+using namespace std;
+
+static const long FRACCION_CALIENTE = 64;
+
+// Sin llamadas ni lecturas de globales: se puede evaluar en cualquier momento.
+static bool independiente(Exp* raiz, const unordered_map<string, bool>& globales) {
+    vector<Exp*> pendientes = {raiz};
+    while (!pendientes.empty()) {
+        Exp* e = pendientes.back();
+        pendientes.pop_back();
+        // los arreglos son globales o locales de quien los declara
+        if (e->kind == FCALL_EXP || e->kind == INDEX_EXP) return false;
+        if (e->kind == IDENTIFIER_EXP && globales.count(static_cast<IdentifierExp*>(e)->name)) return false;
+        if (e->kind == BINARY_EXP) {
+            pendientes.push_back(static_cast<BinaryExp*>(e)->left);
+            pendientes.push_back(static_cast<BinaryExp*>(e)->right);
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            pendientes.push_back(x->condicion);
+            pendientes.push_back(x->entonces);
+            pendientes.push_back(x->sino);
+        }
+    }
+    return true;
+}
+
+Inliner::Inliner(const Perfil& perfil, const list<FunDec*>& funciones, const unordered_map<string, bool>& globales)
+    : perfil(perfil), globales(globales) {
+    long maximo = 0;
+    for (auto f : funciones) {
+        const PerfilFuncion* p = perfil.funcion(f);
+        if (p) recorrerLlamadas(f->cuerpo, [&](FCallExp* l) { maximo = max(maximo, p->sitio(l->sitio)[0]); });
+
+        auto& stms = f->cuerpo->slist->stms;
+        if (!f->cuerpo->vardecs->vardecs.empty() || stms.size() != 1 || stms.front()->kind != RETURN_STM) continue;
+        Exp* valor = static_cast<ReturnStatement*>(stms.front())->e;
+        if (valor == nullptr || !independiente(valor, globales)) continue;
+        Candidata c{f, valor, {}};
+        bool propias = true;
+        for (auto& p : f->parametros) {
+            // un parámetro con nombre de global se resuelve como la global
+            if (globales.count(p)) propias = false;
+            c.usos[p] = 0;
+        }
+        vector<Exp*> pendientes = {valor};
+        while (propias && !pendientes.empty()) {
+            Exp* e = pendientes.back();
+            pendientes.pop_back();
+            if (e->kind == IDENTIFIER_EXP) {
+                auto uso = c.usos.find(static_cast<IdentifierExp*>(e)->name);
+                if (uso == c.usos.end()) propias = false;
+                else uso->second++;
+            } else if (e->kind == BINARY_EXP) {
+                pendientes.push_back(static_cast<BinaryExp*>(e)->left);
+                pendientes.push_back(static_cast<BinaryExp*>(e)->right);
+            } else if (e->kind == INDEX_EXP) {
+                propias = false;
+            } else if (e->kind == IF_EXP) {
+                IfExp* x = static_cast<IfExp*>(e);
+                pendientes.push_back(x->condicion);
+                pendientes.push_back(x->entonces);
+                pendientes.push_back(x->sino);
+            }
+        }
+        if (propias) candidatas.emplace(f->nombre, c);
+    }
+    umbral = max(1L, maximo / FRACCION_CALIENTE);
+}
+
+bool Inliner::expandible(const Candidata& c, FCallExp* llamada) const {
+    if (!actual || actual->sitio(llamada->sitio)[0] < umbral) return false;
+    if (llamada->argumentos.size() != c.f->parametros.size()) return false;
+    for (size_t i = 0; i < llamada->argumentos.size(); i++) {
+        Exp* arg = llamada->argumentos[i];
+        if (!independiente(arg, globales)) return false;
+        if (!arg->esHoja() && c.usos.at(c.f->parametros[i]) != 1) return false;
+    }
+    return true;
+}
+
+Exp* Inliner::copiar(const Candidata& c, FCallExp* llamada) const {
+    unordered_map<string, Exp*> argumentos;
+    for (size_t i = 0; i < c.f->parametros.size(); i++) argumentos[c.f->parametros[i]] = llamada->argumentos[i];
+    Exp* resultado = clonar(c.valor);
+    vector<Exp**> pendientes = {&resultado};
+    while (!pendientes.empty()) {
+        Exp** ranura = pendientes.back();
+        pendientes.pop_back();
+        Exp* e = *ranura;
+        if (e->kind == IDENTIFIER_EXP) {
+            *ranura = clonar(argumentos.at(static_cast<IdentifierExp*>(e)->name));
+            delete e;
+        } else if (e->kind == BINARY_EXP) {
+            pendientes.push_back(&static_cast<BinaryExp*>(e)->left);
+            pendientes.push_back(&static_cast<BinaryExp*>(e)->right);
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            pendientes.push_back(&x->condicion);
+            pendientes.push_back(&x->entonces);
+            pendientes.push_back(&x->sino);
+        }
+    }
+    return resultado;
+}
+
+void Inliner::expandirExp(Exp*& raiz) {
+    vector<Exp**> pendientes = {&raiz};
+    while (!pendientes.empty()) {
+        Exp** ranura = pendientes.back();
+        pendientes.pop_back();
+        Exp* e = *ranura;
+        if (e->kind == BINARY_EXP) {
+            pendientes.push_back(&static_cast<BinaryExp*>(e)->left);
+            pendientes.push_back(&static_cast<BinaryExp*>(e)->right);
+        } else if (e->kind == FCALL_EXP) {
+            FCallExp* llamada = static_cast<FCallExp*>(e);
+            auto c = candidatas.find(llamada->nombre);
+            if (c != candidatas.end() && expandible(c->second, llamada)) {
+                TRAZA(TRAZA_INFO, "inliner: " << llamada->nombre << " expandida (sitio " << llamada->sitio << ")");
+                *ranura = copiar(c->second, llamada);
+                delete llamada;
+                expandidas++;
+                continue;
+            }
+            for (auto& arg : llamada->argumentos) pendientes.push_back(&arg);
+        } else if (e->kind == INDEX_EXP) {
+            pendientes.push_back(&static_cast<IndexExp*>(e)->indice);
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            pendientes.push_back(&x->condicion);
+            pendientes.push_back(&x->entonces);
+            pendientes.push_back(&x->sino);
+        }
+    }
+}
+
+void Inliner::expandirBloque(Body* b) {
+    for (auto s : b->slist->stms) {
+        switch (s->kind) {
+            case ASSIGN_STM: {
+                AssignStatement* a = static_cast<AssignStatement*>(s);
+                if (a->indice) expandirExp(a->indice);
+                expandirExp(a->rhs);
+                break;
+            }
+            case PRINT_STM:
+                expandirExp(static_cast<PrintStatement*>(s)->e); break;
+            case RETURN_STM:
+                if (static_cast<ReturnStatement*>(s)->e) expandirExp(static_cast<ReturnStatement*>(s)->e);
+                break;
+            case IF_STM: {
+                IfStatement* i = static_cast<IfStatement*>(s);
+                expandirExp(i->condition);
+                expandirBloque(i->then);
+                if (i->els) expandirBloque(i->els);
+                break;
+            }
+            case WHILE_STM: {
+                WhileStatement* w = static_cast<WhileStatement*>(s);
+                expandirExp(w->condition);
+                expandirBloque(w->b);
+                break;
+            }
+            case FOR_STM: {
+                ForStatement* f = static_cast<ForStatement*>(s);
+                expandirExp(f->inicio);
+                expandirExp(f->fin);
+                expandirBloque(f->b);
+                break;
+            }
+        }
+    }
+}
+
+void Inliner::expandir(FunDec* f) {
+    actual = perfil.funcion(f);
+    if (actual) expandirBloque(f->cuerpo);
+    actual = nullptr;
+}
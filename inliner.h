@@ -0,0 +1,43 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "exp.h"
+#include "perfil.h"
+using namespace std;
+
+// Expande en el llamador las llamadas calientes según el perfil. Solo se
+// expanden funciones de una sola sentencia `return(e)` sin variables propias,
+// sin llamadas y sin globales: e se copia reemplazando cada parámetro por
+// su argumento. Los argumentos tampoco pueden tener llamadas ni leer
+// globales, así que evaluarlos en otro momento no cambia el resultado; un
+// argumento que no es una hoja solo se acepta si su parámetro aparece una
+// vez en e.
+class Inliner {
+public:
+    Inliner(const Perfil& perfil, const list<FunDec*>& funciones, const unordered_map<string, bool>& globales);
+    void expandir(FunDec* f);
+    long expandidas = 0;
+private:
+    struct Candidata {
+        FunDec* f;
+        Exp* valor;
+        unordered_map<string, int> usos;   // parámetro -> apariciones en valor
+    };
+    bool expandible(const Candidata& c, FCallExp* llamada) const;
+    Exp* copiar(const Candidata& c, FCallExp* llamada) const;
+    void expandirExp(Exp*& raiz);
+    void expandirBloque(Body* b);
+
+    const Perfil& perfil;
+    const unordered_map<string, bool>& globales;
+    unordered_map<string, Candidata> candidatas;
+    // una llamada es caliente si se ejecutó al menos 1/FRACCION_CALIENTE
+    // veces lo que la llamada más ejecutada del programa
+    long umbral = 1;
+    const PerfilFuncion* actual = nullptr;
+};
+
+#endif // INLINER_H
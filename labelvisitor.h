@@ -1,119 +1,249 @@
-#ifndef LABEL_VISITOR_H
-#define LABEL_VISITOR_H
-
-#include "visitor.h"
-#include "exp.h"
-#include <algorithm>
-#include <iostream>
-using namespace std;
-
-class LabelVisitor : public Visitor {
-public:
-    bool leftChild = true;
-
-    int visit(NumberExp* e) override {
-        e->etiqueta = leftChild ? 1 : 0;
-        cout << "NumberExp(" << e->value << ") => etiqueta = " << e->etiqueta << endl;
-        return e->etiqueta;
-    }
-
-    int visit(BoolExp* e) override {
-        e->etiqueta = leftChild ? 1 : 0;
-        cout << "BoolExp(" << e->value << ") => etiqueta = " << e->etiqueta << endl;
-        return e->etiqueta;
-    }
-
-    int visit(IdentifierExp* e) override {
-        e->etiqueta = leftChild ? 1 : 0;
-        cout << "IdentifierExp(" << e->name << ") => etiqueta = " << e->etiqueta << endl;
-        return e->etiqueta;
-    }
-
-    int visit(BinaryExp* e) override {
-        leftChild = true;
-        int l = e->left->accept(this);
-
-        leftChild = false;
-        int r = e->right->accept(this);
-
-        e->etiqueta = (l == r) ? l + 1 : std::max(l, r);
-
-        string op;
-        switch (e->op) {
-            case PLUS_OP:  op = "+"; break;
-            case MINUS_OP: op = "-"; break;
-            case MUL_OP:   op = "*"; break;
-            case DIV_OP:   op = "/"; break;
-            case EQ_OP:    op = "=="; break;
-            case LT_OP:    op = "<"; break;
-            case LE_OP:    op = "<="; break;
-            default:       op = "?"; break;
-        }
-
-        cout << "BinaryExp(" << op << ") con etiquetas hijos (" << l << ", " << r << ") => etiqueta = " << e->etiqueta << endl;
-
-        return e->etiqueta;
-    }
-
-    int visit(FCallExp* e) override {
-        int max_arg = 0;
-        for (auto arg : e->argumentos) {
-            leftChild = true; // neutral
-            max_arg = std::max(max_arg, arg->accept(this));
-        }
-        e->etiqueta = max_arg;
-        cout << "FCallExp(" << e->nombre << ") => etiqueta = " << e->etiqueta << endl;
-        return e->etiqueta;
-    }
-
-    void visit(AssignStatement* s) override {
-        s->rhs->accept(this);
-    }
-
-    void visit(PrintStatement* s) override {
-        s->e->accept(this);
-    }
-
-    void visit(ReturnStatement* s) override {
-        s->e->accept(this);
-    }
-
-    void visit(IfStatement* s) override {
-        s->condition->accept(this);
-        if (s->then) s->then->accept(this);
-        if (s->els) s->els->accept(this);
-    }
-
-    void visit(WhileStatement* s) override {
-        s->condition->accept(this);
-        if (s->b) s->b->accept(this);
-    }
-
-    void visit(VarDec* v) override {}
-    void visit(VarDecList* v) override {}
-
-    void visit(StatementList* sl) override {
-        for (auto s : sl->stms) {
-            s->accept(this);
-        }
-    }
-
-    void visit(Body* b) override {
-        if (b->slist) b->slist->accept(this);
-    }
-
-    void visit(FunDec* f) override {
-        if (f->cuerpo) f->cuerpo->accept(this);
-    }
-
-    void visit(FunDecList* l) override {
-        for (auto f : l->Fundecs) {
-            f->accept(this);
-        }
-    }
-    void visit(Program* p) override {
-        if (p->fundecs) p->fundecs->accept(this);
-    }
-};
-
-#endif // LABEL_VISITOR_H
+#ifndef LABEL_VISITOR_H
+#define LABEL_VISITOR_H
+
+#include "visitor.h"
+#include "exp.h"
+#include "trace.h"
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+class LabelVisitor : public Visitor {
+public:
+    bool leftChild = true;
+
+    int visit(NumberExp* e) override {
+        e->etiqueta = leftChild ? 1 : 0;
+        TRAZA(TRAZA_DEBUG, "NumberExp(" << e->value << ") => etiqueta = " << e->etiqueta);
+        return e->etiqueta;
+    }
+
+    int visit(BoolExp* e) override {
+        e->etiqueta = leftChild ? 1 : 0;
+        TRAZA(TRAZA_DEBUG, "BoolExp(" << e->value << ") => etiqueta = " << e->etiqueta);
+        return e->etiqueta;
+    }
+
+    int visit(IdentifierExp* e) override {
+        e->etiqueta = leftChild ? 1 : 0;
+        TRAZA(TRAZA_DEBUG, "IdentifierExp(" << e->name << ") => etiqueta = " << e->etiqueta);
+        return e->etiqueta;
+    }
+
+    int visit(BinaryExp* e) override {
+        return etiquetar(e);
+    }
+
+    int visit(FCallExp* e) override {
+        return etiquetar(e);
+    }
+
+    int visit(IndexExp* e) override {
+        return etiquetar(e);
+    }
+
+    int visit(IfExp* e) override {
+        return etiquetar(e);
+    }
+
+    void visit(AssignStatement* s) override {
+        if (s->indice) s->indice->accept(this);
+        s->rhs->accept(this);
+    }
+
+    void visit(PrintStatement* s) override {
+        s->e->accept(this);
+    }
+
+    void visit(ReturnStatement* s) override {
+        s->e->accept(this);
+    }
+
+    void visit(IfStatement* s) override {
+        etiquetarSentencias(nullptr, s);
+    }
+
+    void visit(WhileStatement* s) override {
+        etiquetarSentencias(nullptr, s);
+    }
+
+    void visit(ForStatement* s) override {
+        etiquetarSentencias(nullptr, s);
+    }
+
+    void visit(VarDec*) override {}
+    void visit(VarDecList*) override {}
+
+    void visit(StatementList* sl) override {
+        for (auto s : sl->stms) {
+            s->accept(this);
+        }
+    }
+
+    void visit(Body* b) override {
+        etiquetarSentencias(b, nullptr);
+    }
+
+    void visit(FunDec* f) override {
+        if (f->cuerpo) f->cuerpo->accept(this);
+    }
+
+    void visit(FunDecList* l) override {
+        for (auto f : l->Fundecs) {
+            f->accept(this);
+        }
+    }
+    void visit(Program* p) override {
+        if (p->fundecs) p->fundecs->accept(this);
+    }
+
+private:
+    struct Marco {
+        Exp* e;
+        size_t etapa;
+        bool izquierdo;   // leftChild al llegar al nodo
+    };
+    // se reutilizan entre llamadas
+    vector<Marco> pila;
+    vector<Stm*> pilaStm;
+
+    // Recorre el árbol en postorden con una pila explícita, en el mismo
+    // orden (y con los mismos cambios de leftChild) que la versión
+    // recursiva, para no agotar la pila con cadenas muy largas.
+    int etiquetar(Exp* raiz) {
+        if (raiz->esHoja()) return raiz->accept(this);
+        size_t base = pila.size();
+        pila.push_back({raiz, 0, leftChild});
+        while (pila.size() > base) {
+            Marco& m = pila.back();
+            if (m.e->kind == BINARY_EXP) {
+                BinaryExp* e = static_cast<BinaryExp*>(m.e);
+                if (m.etapa == 0) {
+                    m.etapa = 1;
+                    leftChild = true;
+                    if (!e->left->esHoja()) {
+                        pila.push_back({e->left, 0, true});
+                        continue;
+                    }
+                    e->left->accept(this);
+                }
+                if (m.etapa == 1) {
+                    m.etapa = 2;
+                    leftChild = false;
+                    if (!e->right->esHoja()) {
+                        pila.push_back({e->right, 0, false});
+                        continue;
+                    }
+                    e->right->accept(this);
+                }
+                int l = e->left->etiqueta;
+                int r = e->right->etiqueta;
+                e->etiqueta = (l == r) ? l + 1 : std::max(l, r);
+                e->sinEfectos = e->op != DIV_OP && e->left->sinEfectos && e->right->sinEfectos;
+                TRAZA(TRAZA_DEBUG, "BinaryExp(" << Exp::binopToChar(e->op) << ") con etiquetas hijos ("
+                      << l << ", " << r << ") => etiqueta = " << e->etiqueta);
+            } else if (m.e->kind == INDEX_EXP) {
+                IndexExp* e = static_cast<IndexExp*>(m.e);
+                if (m.etapa == 0) {
+                    m.etapa = 1;
+                    leftChild = true;
+                    if (!e->indice->esHoja()) {
+                        pila.push_back({e->indice, 0, true});
+                        continue;
+                    }
+                    e->indice->accept(this);
+                }
+                // con el índice hoja, a[i] se carga sin usar %rcx: cuenta
+                // como una hoja
+                if (e->indice->esHoja()) e->etiqueta = m.izquierdo ? 1 : 0;
+                else e->etiqueta = std::max(1, e->indice->etiqueta);
+                e->sinEfectos = false;
+                TRAZA(TRAZA_DEBUG, "IndexExp(" << e->nombre << ") => etiqueta = " << e->etiqueta);
+            } else if (m.e->kind == IF_EXP) {
+                // cada parte se evalúa sola en %rax; la ifexp necesita al
+                // menos un registro
+                IfExp* e = static_cast<IfExp*>(m.e);
+                Exp* partes[] = {e->condicion, e->entonces, e->sino};
+                bool pendiente = false;
+                while (m.etapa < 3) {
+                    Exp* parte = partes[m.etapa++];
+                    leftChild = true;
+                    if (!parte->esHoja()) {
+                        pila.push_back({parte, 0, true});
+                        pendiente = true;
+                        break;
+                    }
+                    parte->accept(this);
+                }
+                if (pendiente) continue;
+                e->etiqueta = std::max({1, e->condicion->etiqueta, e->entonces->etiqueta, e->sino->etiqueta});
+                // con cmov las ramas se evalúan antes que la condición: una
+                // llamada en ella podría cambiar lo que las ramas ya leyeron
+                e->sinEfectos = e->condicion->sinEfectos && e->entonces->sinEfectos && e->sino->sinEfectos;
+                e->cmov = e->sinEfectos;
+                TRAZA(TRAZA_DEBUG, "IfExp => etiqueta = " << e->etiqueta);
+            } else {
+                FCallExp* e = static_cast<FCallExp*>(m.e);
+                bool pendiente = false;
+                while (m.etapa < e->argumentos.size()) {
+                    Exp* arg = e->argumentos[m.etapa++];
+                    leftChild = true; // neutral
+                    if (!arg->esHoja()) {
+                        pila.push_back({arg, 0, true});
+                        pendiente = true;
+                        break;
+                    }
+                    arg->accept(this);
+                }
+                if (pendiente) continue;
+                // al menos 1 aunque no tenga argumentos (un clon de
+                // --ipcp): la llamada pisa %rcx, nunca es DIRECTO
+                int max_arg = 1;
+                for (auto arg : e->argumentos) max_arg = std::max(max_arg, arg->etiqueta);
+                e->etiqueta = max_arg;
+                e->sinEfectos = false;
+                TRAZA(TRAZA_DEBUG, "FCallExp(" << e->nombre << ") => etiqueta = " << e->etiqueta);
+            }
+            pila.pop_back();
+        }
+        return raiz->etiqueta;
+    }
+
+    static void apilar(Body* b, vector<Stm*>& pila) {
+        if (b == nullptr || b->slist == nullptr) return;
+        for (auto it = b->slist->stms.rbegin(); it != b->slist->stms.rend(); ++it) {
+            pila.push_back(*it);
+        }
+    }
+
+    // if/while/for anidados sin recursión: las sentencias de cada bloque se
+    // apilan en orden inverso para visitarlas en preorden.
+    void etiquetarSentencias(Body* cuerpo, Stm* stm) {
+        size_t base = pilaStm.size();
+        if (stm) pilaStm.push_back(stm);
+        else apilar(cuerpo, pilaStm);
+        while (pilaStm.size() > base) {
+            Stm* s = pilaStm.back();
+            pilaStm.pop_back();
+            if (s->kind == IF_STM) {
+                IfStatement* i = static_cast<IfStatement*>(s);
+                i->condition->accept(this);
+                apilar(i->els, pilaStm);
+                apilar(i->then, pilaStm);
+            } else if (s->kind == WHILE_STM) {
+                WhileStatement* w = static_cast<WhileStatement*>(s);
+                w->condition->accept(this);
+                apilar(w->b, pilaStm);
+            } else if (s->kind == FOR_STM) {
+                ForStatement* f = static_cast<ForStatement*>(s);
+                f->inicio->accept(this);
+                f->fin->accept(this);
+                apilar(f->b, pilaStm);
+            } else {
+                s->accept(this);
+            }
+        }
+    }
+};
+
+#endif // LABEL_VISITOR_H
@@ -1,58 +1,177 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-#include "scanner.h"
-#include "parser.h"
-#include "visitor.h"
-#include "labelvisitor.h"
-
-using namespace std;
-
-int main(int argc, const char* argv[]) {
-    if (argc != 2) {
-        cout << "Numero incorrecto de argumentos. Uso: " << argv[0] << " <archivo_de_entrada>" << endl;
-        exit(1);
-    }
-
-    ifstream infile(argv[1]);
-    if (!infile.is_open()) {
-        cout << "No se pudo abrir el archivo: " << argv[1] << endl;
-        exit(1);
-    }
-
-    string input;
-    string line;
-    while (getline(infile, line)) {
-        input += line + '\n';
-    }
-    infile.close();
-
-    Scanner scanner(input.c_str());
-
-    string input_copy = input;
-    Scanner scanner_test(input_copy.c_str());
-    Parser parser(&scanner); 
-    try {
-        Program* program = parser.parseProgram();     
-        string inputFile(argv[1]);
-        size_t dotPos = inputFile.find_last_of('.');
-        string baseName = (dotPos == string::npos) ? inputFile : inputFile.substr(0, dotPos);
-        string outputFilename = baseName + ".s";
-        ofstream outfile(outputFilename);
-        if (!outfile.is_open()) {
-            cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
-            return 1;
-        }
-        cout << "Generando codigo ensamblador en " << outputFilename << endl;
-        LabelVisitor labeler;
-        labeler.visit(program);
-        GenCodeVisitor codigo(outfile);
-        codigo.generar(program);
-        outfile.close();
-        delete program;
-    } catch (const exception& e) {
-        cout << "Error durante la ejecución: " << e.what() << endl;
-        return 1;
-    }
-    return 0;
-}
\ No newline at end of file
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "compiler.h"
+#include "perfil.h"
+#include "server.h"
+#include "stats.h"
+#include "trace.h"
+
+using namespace std;
+
+int main(int argc, const char* argv[]) {
+    CompileOptions opciones;
+    OpcionesServidor servidor;
+    string conectarA;
+    bool conStats = false;
+    bool statsJSON = false;
+    bool statsServidor = false;
+    string perfilUsar;
+    bool depuracion = false;
+    bool avx2 = false;
+    vector<string> archivos;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--incremental") {
+            opciones.incremental = true;
+        } else if (arg == "--stats" || arg == "--stats=text") {
+            conStats = true;
+        } else if (arg == "--stats=json") {
+            conStats = true;
+            statsJSON = true;
+        } else if (arg == "-O0") {
+            opciones.optimizacion.desenrollar = 0;
+            opciones.optimizacion.vectorizar = 0;
+        } else if (arg == "-O1") {
+            opciones.optimizacion.desenrollar = 4;
+            opciones.optimizacion.vectorizar = 2;
+        } else if (arg == "-mavx2") {
+            avx2 = true;
+        } else if (arg.rfind("--unroll=", 0) == 0) {
+            opciones.optimizacion.desenrollar = min(255, max(0, atoi(arg.c_str() + 9)));
+        } else if (arg == "--profile-generate") {
+            opciones.perfilGenerar = "lab20.perfil";
+        } else if (arg.rfind("--profile-generate=", 0) == 0) {
+            opciones.perfilGenerar = arg.substr(19);
+        } else if (arg.rfind("--profile-use=", 0) == 0) {
+            perfilUsar = arg.substr(14);
+        } else if (arg == "--memoize") {
+            opciones.memoizar = true;
+        } else if (arg == "--ipcp") {
+            opciones.especializar = PRESUPUESTO_ESPECIALIZACION;
+        } else if (arg.rfind("--ipcp=", 0) == 0) {
+            opciones.especializar = max(0, atoi(arg.c_str() + 7));
+        } else if (arg == "-g") {
+            depuracion = true;
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            Traza::nivel = atoi(arg.c_str() + 8);
+        } else if (arg.rfind("--serve=", 0) == 0) {
+            servidor.socket = arg.substr(8);
+        } else if (arg.rfind("--workers=", 0) == 0) {
+            servidor.trabajadores = max(1, atoi(arg.c_str() + 10));
+        } else if (arg.rfind("--cola=", 0) == 0) {
+            servidor.capacidadCola = max(1, atoi(arg.c_str() + 7));
+        } else if (arg.rfind("--server=", 0) == 0) {
+            conectarA = arg.substr(9);
+        } else if (arg == "--server-stats") {
+            statsServidor = true;
+        } else {
+            archivos.push_back(arg);
+        }
+    }
+    // -mavx2 solo elige el ancho: vectoriza quien ya pidió -O1
+    if (avx2 && opciones.optimizacion.vectorizar) opciones.optimizacion.vectorizar = 4;
+    if (!servidor.socket.empty()) {
+        return CompileServer(servidor).ejecutar();
+    }
+    if (conectarA.empty() && getenv("LAB20_SERVER") != nullptr) {
+        conectarA = getenv("LAB20_SERVER");
+    }
+    if (!conectarA.empty()) {
+        if (statsServidor) {
+            return ejecutarCliente(conectarA, {""}, FLAG_ESTADISTICAS);
+        }
+        if (!archivos.empty()) {
+            uint32_t flags = opciones.incremental ? FLAG_INCREMENTAL : 0;
+            flags |= (uint32_t) opciones.optimizacion.desenrollar << 8;
+            flags |= (uint32_t) opciones.optimizacion.vectorizar << 16;
+            if (opciones.memoizar) flags |= FLAG_MEMOIZAR;
+            if (opciones.especializar) flags |= FLAG_ESPECIALIZAR;
+            return ejecutarCliente(conectarA, archivos, flags);
+        }
+    }
+    if (archivos.size() != 1) {
+        cout << "Numero incorrecto de argumentos. Uso: " << argv[0] << " [--incremental] [-O0|-O1] [-mavx2] [--unroll=N] [--profile-generate[=perfil] | --profile-use=perfil] [--memoize] [--ipcp[=N]] [-g] [--stats[=text|json]] [--trace=N] <archivo_de_entrada>" << endl;
+        cout << "       " << argv[0] << " --serve=<socket> [--workers=N] [--cola=N]" << endl;
+        cout << "       " << argv[0] << " --server=<socket> [--incremental] [-O1] [-mavx2] [--unroll=N] [--memoize] [--ipcp] <archivo>... | --server-stats" << endl;
+        exit(1);
+    }
+    const char* archivo = archivos[0].c_str();
+    if (depuracion) opciones.fuenteDepuracion = archivos[0];
+
+    Perfil perfil;
+    if (!perfilUsar.empty()) {
+        string error;
+        if (!perfil.cargar(perfilUsar, error)) {
+            cout << error << endl;
+            exit(1);
+        }
+        opciones.optimizacion.perfil = &perfil;
+    }
+
+    Stats stats;
+    if (conStats) opciones.stats = &stats;
+    stats.iniciarFase("lectura");
+    ifstream infile(archivo);
+    if (!infile.is_open()) {
+        cout << "No se pudo abrir el archivo: " << archivo << endl;
+        exit(1);
+    }
+
+    string input;
+    string line;
+    while (getline(infile, line)) {
+        input += line + '\n';
+    }
+    infile.close();
+    stats.terminarFase();
+
+    string inputFile(archivo);
+    size_t dotPos = inputFile.find_last_of('.');
+    string baseName = (dotPos == string::npos) ? inputFile : inputFile.substr(0, dotPos);
+    string outputFilename = baseName + ".s";
+    string cacheFilename = baseName + ".cache";
+
+    CompilerContext contexto;
+    if (opciones.incremental) {
+        contexto.cacheIncremental().cargarCache(cacheFilename);
+    }
+
+    int outfd = open(outputFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outfd < 0) {
+        cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
+        return 1;
+    }
+    cout << "Generando codigo ensamblador en " << outputFilename << endl;
+    Emitter outfile(outfd);
+    bool ok = contexto.compile(input, opciones, outfile);
+    if (!outfile.flush()) {
+        cerr << "Error al escribir el archivo de salida: " << outputFilename << endl;
+        ok = false;
+    }
+    close(outfd);
+    if (!ok) {
+        for (auto& d : contexto.diagnosticos()) {
+            cout << archivo << ":" << d.linea << ":" << d.columna << ": error: " << d.mensaje << endl;
+        }
+        unlink(outputFilename.c_str());
+        return 1;
+    }
+
+    if (opciones.incremental) {
+        IncrementalCompiler& cache = contexto.cacheIncremental();
+        if (!cache.guardarCache(cacheFilename)) {
+            cerr << "No se pudo guardar la cache: " << cacheFilename << endl;
+        }
+        cout << "Funciones reutilizadas: " << cache.reutilizadas
+             << ", regeneradas: " << cache.regeneradas << endl;
+    }
+    if (conStats) {
+        if (statsJSON) stats.imprimirJSON(cerr);
+        else stats.imprimir(cerr);
+    }
+    return 0;
+}
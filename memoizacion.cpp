@@ -0,0 +1,105 @@
+#include <unordered_set>
+#include <vector>
+#include "exp.h"
+#include "memoizacion.h"
+#include "trace.h"
+
+using namespace std;
+
+// más no entran en una entrada de 32 bytes (claves, valor y ocupada)
+static const size_t MAX_PARAMETROS_MEMO = 2;
+
+// Lo que una función hace con el resto del programa.
+struct Efectos {
+    bool impura = false;                // imprime o usa una global
+    unordered_set<string> llamadas;
+    unordered_set<string> asignadas;
+};
+
+static void anotarEfectos(Body* b, const unordered_map<string, bool>& globales, Efectos& ef) {
+    recorrerSentencias(b, [&](Stm* s) {
+        if (s->kind == PRINT_STM) {
+            ef.impura = true;
+        } else if (s->kind == ASSIGN_STM || s->kind == FOR_STM) {
+            const string& id = s->kind == ASSIGN_STM ? static_cast<AssignStatement*>(s)->id
+                                                     : static_cast<ForStatement*>(s)->variable;
+            if (globales.count(id)) ef.impura = true;
+            ef.asignadas.insert(id);
+        }
+    });
+    recorrerExpresiones(b, [&](Exp* e) {
+        if (e->kind == IDENTIFIER_EXP) {
+            if (globales.count(static_cast<IdentifierExp*>(e)->name)) ef.impura = true;
+        } else if (e->kind == INDEX_EXP) {
+            if (globales.count(static_cast<IndexExp*>(e)->nombre)) ef.impura = true;
+        } else if (e->kind == FCALL_EXP) {
+            ef.llamadas.insert(static_cast<FCallExp*>(e)->nombre);
+        }
+    });
+}
+
+int marcarMemoizables(const list<FunDec*>& funciones, const unordered_map<string, bool>& globales) {
+    unordered_map<string, Efectos> efectos;
+    for (auto f : funciones) {
+        // un parámetro con nombre de global se resuelve como la global
+        Efectos& ef = efectos[f->nombre];
+        for (auto& p : f->parametros) {
+            if (globales.count(p)) ef.impura = true;
+        }
+        anotarEfectos(f->cuerpo, globales, ef);
+    }
+
+    // puras: se descartan las que llaman a una impura hasta que no cambia
+    unordered_set<string> puras;
+    for (auto& [nombre, ef] : efectos) {
+        if (!ef.impura) puras.insert(nombre);
+    }
+    bool cambio = true;
+    while (cambio) {
+        cambio = false;
+        for (auto it = puras.begin(); it != puras.end(); ) {
+            bool impura = false;
+            for (auto& l : efectos[*it].llamadas) {
+                if (!puras.count(l)) impura = true;
+            }
+            if (impura) {
+                it = puras.erase(it);
+                cambio = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    int marcadas = 0;
+    for (auto f : funciones) {
+        f->memoizar = false;
+        size_t n = f->parametros.size();
+        if (!puras.count(f->nombre) || n == 0 || n > MAX_PARAMETROS_MEMO) continue;
+        // la tabla se llena al salir con los parámetros como claves
+        const Efectos& ef = efectos[f->nombre];
+        bool reasigna = false;
+        for (auto& p : f->parametros) {
+            if (ef.asignadas.count(p)) reasigna = true;
+        }
+        if (reasigna) continue;
+        // recursiva: se llega a sí misma por el grafo de llamadas
+        unordered_set<string> vistas;
+        vector<string> pendientes(ef.llamadas.begin(), ef.llamadas.end());
+        bool recursiva = false;
+        while (!pendientes.empty() && !recursiva) {
+            string g = pendientes.back();
+            pendientes.pop_back();
+            if (g == f->nombre) recursiva = true;
+            else if (vistas.insert(g).second) {
+                auto& siguientes = efectos[g].llamadas;
+                pendientes.insert(pendientes.end(), siguientes.begin(), siguientes.end());
+            }
+        }
+        if (!recursiva) continue;
+        TRAZA(TRAZA_INFO, "memoizacion: " << f->nombre << " es pura y recursiva");
+        f->memoizar = true;
+        marcadas++;
+    }
+    return marcadas;
+}
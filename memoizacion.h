@@ -0,0 +1,25 @@
+#ifndef MEMOIZACION_H
+#define MEMOIZACION_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+class FunDec;
+
+// Memoización automática (--memoize).
+//
+// Una función es pura si no lee ni escribe globales, no imprime y solo
+// llama a funciones puras: su resultado depende solo de sus argumentos. Se
+// marcan con FunDec::memoizar las puras que además son recursivas (directa
+// o mutuamente), tienen uno o dos parámetros y no los reasignan.
+// GenCodeVisitor les agrega una tabla de correspondencia directa en .bss
+// que consulta al entrar y llena al salir, así una recursión exponencial
+// como fib calcula cada valor una sola vez.
+//
+// Necesita el grafo de llamadas completo: solo sirve para la compilación
+// del programa entero. Devuelve cuántas funciones marcó.
+int marcarMemoizables(const list<FunDec*>& funciones, const unordered_map<string, bool>& globales);
+
+#endif // MEMOIZACION_H
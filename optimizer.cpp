@@ -0,0 +1,573 @@
+#include <climits>
+#include <vector>
+#include "optimizer.h"
+#include "trace.h"
+
+using namespace std;
+
+// Tope de sentencias que puede producir un desenrollado (contando las de
+// los bloques anidados): más copias ya no compensan el tamaño del código.
+static const int MAX_SENTENCIAS = 64;
+
+uint64_t OpcionesOptimizacion::huella() const {
+    if (!activa()) return 0;
+    uint64_t h = 14695981039346656037ULL;
+    for (uint64_t v : {(uint64_t) desenrollar, (uint64_t) vueltasCompleto, perfil ? perfil->huella() : 0,
+                       (uint64_t) vectorizar}) {
+        h ^= v;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static bool contieneLlamadas(Exp* e) {
+    bool llamadas = false;
+    recorrer(e, [&](Exp* n) { if (n->kind == FCALL_EXP) llamadas = true; });
+    return llamadas;
+}
+
+static bool cabeEnInt(long v) {
+    return v >= INT_MIN && v <= INT_MAX;
+}
+
+// Constante del mismo tipo que la expresión a la que reemplaza.
+static Exp* constante(long v, Tipo tipo) {
+    if (tipo == TIPO_BOOL) return new BoolExp(v != 0);
+    return new NumberExp((int) v);
+}
+
+// Lo que hace un cuerpo, contando sus bloques anidados.
+struct Resumen {
+    unordered_map<string, int> asignadas;   // variable -> número de asignaciones
+    int sentencias = 0;
+    bool llamadas = false;
+    bool declaraciones = false;
+    bool bucles = false;
+};
+
+static void resumir(Body* b, Resumen& r) {
+    if (!b->vardecs->vardecs.empty()) r.declaraciones = true;
+    for (auto s : b->slist->stms) {
+        r.sentencias++;
+        switch (s->kind) {
+            case ASSIGN_STM: {
+                AssignStatement* a = static_cast<AssignStatement*>(s);
+                r.asignadas[a->id]++;
+                if (contieneLlamadas(a->rhs) || (a->indice && contieneLlamadas(a->indice))) r.llamadas = true;
+                break;
+            }
+            case PRINT_STM:
+                if (contieneLlamadas(static_cast<PrintStatement*>(s)->e)) r.llamadas = true;
+                break;
+            case RETURN_STM: {
+                Exp* e = static_cast<ReturnStatement*>(s)->e;
+                if (e && contieneLlamadas(e)) r.llamadas = true;
+                break;
+            }
+            case IF_STM: {
+                IfStatement* i = static_cast<IfStatement*>(s);
+                if (contieneLlamadas(i->condition)) r.llamadas = true;
+                resumir(i->then, r);
+                if (i->els) resumir(i->els, r);
+                break;
+            }
+            case WHILE_STM: {
+                WhileStatement* w = static_cast<WhileStatement*>(s);
+                r.bucles = true;
+                if (contieneLlamadas(w->condition)) r.llamadas = true;
+                resumir(w->b, r);
+                break;
+            }
+            case FOR_STM: {
+                ForStatement* f = static_cast<ForStatement*>(s);
+                r.bucles = true;
+                r.asignadas[f->variable]++;
+                if (contieneLlamadas(f->inicio) || contieneLlamadas(f->fin)) r.llamadas = true;
+                resumir(f->b, r);
+                break;
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+
+void Optimizer::optimizar(FunDec* f, const unordered_map<string, bool>& globales) {
+    locales.clear();
+    generados.clear();
+    perfilFuncion = opciones.perfil ? opciones.perfil->funcion(f) : nullptr;
+    for (auto& p : f->parametros) locales.insert(p);
+    declarar(f->cuerpo);
+    // GenCodeVisitor resuelve primero las globales aunque haya una local
+    // con el mismo nombre
+    for (auto& [g, _] : globales) locales.erase(g);
+    Constantes conocidas;
+    optimizarBloque(f->cuerpo, conocidas, true);
+}
+
+void Optimizer::declarar(Body* b) {
+    for (auto dec : b->vardecs->vardecs) {
+        if (dec->longitud) continue;
+        for (auto& v : dec->vars) locales.insert(v);
+    }
+    for (auto s : b->slist->stms) {
+        if (s->kind == IF_STM) {
+            IfStatement* i = static_cast<IfStatement*>(s);
+            declarar(i->then);
+            if (i->els) declarar(i->els);
+        } else if (s->kind == WHILE_STM) {
+            declarar(static_cast<WhileStatement*>(s)->b);
+        } else if (s->kind == FOR_STM) {
+            declarar(static_cast<ForStatement*>(s)->b);
+        }
+    }
+}
+
+// conocidas: locales con valor constante al entrar al bloque; a la salida,
+// las que lo siguen teniendo.
+void Optimizer::optimizarBloque(Body* b, Constantes& conocidas, bool finDeFuncion) {
+    auto& stms = b->slist->stms;
+    for (auto it = stms.begin(); it != stms.end(); ) {
+        Stm* s = *it;
+        switch (s->kind) {
+            case ASSIGN_STM: {
+                AssignStatement* a = static_cast<AssignStatement*>(s);
+                a->rhs = plegar(a->rhs, conocidas);
+                if (a->indice) a->indice = plegar(a->indice, conocidas);
+                long valor;
+                if (locales.count(a->id) && esConstante(a->rhs, valor)) conocidas[a->id] = (int) valor;
+                else conocidas.erase(a->id);
+                ++it;
+                break;
+            }
+            case PRINT_STM: {
+                PrintStatement* p = static_cast<PrintStatement*>(s);
+                p->e = plegar(p->e, conocidas);
+                ++it;
+                break;
+            }
+            case RETURN_STM: {
+                ReturnStatement* r = static_cast<ReturnStatement*>(s);
+                if (r->e) r->e = plegar(r->e, conocidas);
+                ++it;
+                break;
+            }
+            case IF_STM: {
+                IfStatement* i = static_cast<IfStatement*>(s);
+                i->condition = plegar(i->condition, conocidas);
+                long valor;
+                if (esConstante(i->condition, valor)) {
+                    it = podar(stms, it, valor != 0, conocidas);
+                    break;
+                }
+                Constantes porElse = conocidas;
+                optimizarBloque(i->then, conocidas);
+                if (i->els) optimizarBloque(i->els, porElse);
+                // solo sigue conocido lo que vale lo mismo por ambas ramas
+                for (auto k = conocidas.begin(); k != conocidas.end(); ) {
+                    auto otra = porElse.find(k->first);
+                    if (otra == porElse.end() || otra->second != k->second) k = conocidas.erase(k);
+                    else ++k;
+                }
+                ++it;
+                break;
+            }
+            case WHILE_STM:
+                it = optimizarWhile(stms, it, conocidas);
+                break;
+            case FOR_STM: {
+                // como un while que no se desenrolla: la variable y lo que
+                // asigna el cuerpo dejan de ser conocidos desde la entrada
+                ForStatement* f = static_cast<ForStatement*>(s);
+                f->inicio = plegar(f->inicio, conocidas);
+                Resumen resumen;
+                resumir(f->b, resumen);
+                conocidas.erase(f->variable);
+                for (auto& [v, _] : resumen.asignadas) conocidas.erase(v);
+                f->fin = plegar(f->fin, conocidas);
+                Constantes dentro = conocidas;
+                optimizarBloque(f->b, dentro);
+                ++it;
+                break;
+            }
+        }
+    }
+    eliminarAsignacionesMuertas(stms, finDeFuncion);
+}
+
+// Deja solo la rama que toma un if de condición constante. Si la rama no
+// declara variables sus sentencias reemplazan al if y el recorrido sigue
+// por la primera, con lo que se conocía antes del if; si declara, queda
+// como un if de condición true sin else.
+list<Stm*>::iterator Optimizer::podar(list<Stm*>& stms, list<Stm*>::iterator it, bool entonces,
+                                      Constantes& conocidas) {
+    IfStatement* i = static_cast<IfStatement*>(*it);
+    Body* tomada = entonces ? i->then : i->els;
+    delete (entonces ? i->els : i->then);
+    i->then = tomada;
+    i->els = nullptr;
+    ramasEliminadas++;
+    TRAZA(TRAZA_INFO, "optimizador: if siempre " << string_view(entonces ? "verdadero" : "falso") << " sin su otra rama");
+    if (tomada == nullptr || tomada->vardecs->vardecs.empty()) {
+        if (tomada) stms.splice(next(it), tomada->slist->stms);
+        delete i;
+        return stms.erase(it);
+    }
+    delete i->condition;
+    i->condition = new BoolExp(true);
+    optimizarBloque(i->then, conocidas);
+    return next(it);
+}
+
+// Devuelve la posición desde donde sigue el recorrido del bloque. Si el
+// bucle se desenrolla entero, esa posición es la primera copia del cuerpo:
+// así las copias se pliegan con los valores que entran al bucle.
+list<Stm*>::iterator Optimizer::optimizarWhile(list<Stm*>& stms, list<Stm*>::iterator it, Constantes& conocidas) {
+    WhileStatement* w = static_cast<WhileStatement*>(*it);
+    // una copia de un bucle ya vectorizado se vuelve a analizar: su cuerpo
+    // puede cambiar al plegarse con otros valores
+    delete w->vectorial;
+    w->vectorial = nullptr;
+    Resumen resumen;
+    resumir(w->b, resumen);
+    Constantes entrada = conocidas;
+    for (auto& [v, _] : resumen.asignadas) conocidas.erase(v);
+    // lo que no se asigna en el bucle vale lo mismo en cada vuelta
+    w->condition = plegar(w->condition, conocidas);
+    Constantes dentro = conocidas;
+    optimizarBloque(w->b, dentro);
+    if (generados.count(w)) return next(it);
+
+    Bucle bucle;
+    if (!reconocer(w, bucle)) return next(it);
+    // el epílogo escalar de un bucle vectorizado da menos de ancho vueltas:
+    // no se desenrolla
+    if ((w->vectorial = vectorial(w, bucle))) {
+        TRAZA(TRAZA_INFO, "optimizador: while de " << bucle.variable << " vectorizado x" << w->vectorial->ancho);
+        vectorizados++;
+        return next(it);
+    }
+    int factor = factorDe(w);
+    if (factor == 0) return next(it);
+    long inicio, limite;
+    auto conocida = entrada.find(bucle.variable);
+    if (conocida != entrada.end() && esConstante(bucle.limite, limite)) {
+        inicio = conocida->second;
+        long vueltas;
+        if (bucle.op == LT_OP) vueltas = inicio >= limite ? 0 : (limite - inicio + bucle.paso - 1) / bucle.paso;
+        else vueltas = inicio > limite ? 0 : (limite - inicio) / bucle.paso + 1;
+        if (vueltas <= opciones.vueltasCompleto && vueltas * bucle.sentencias <= MAX_SENTENCIAS) {
+            TRAZA(TRAZA_INFO, "optimizador: while de " << bucle.variable << " desenrollado entero ("
+                  << vueltas << " vueltas)");
+            auto primera = it;
+            for (long v = 0; v < vueltas; v++) {
+                for (auto s : w->b->slist->stms) stms.insert(it, clonar(s));
+            }
+            if (vueltas > 0) primera = prev(it, vueltas * w->b->slist->stms.size());
+            else primera = next(it);
+            stms.erase(it);
+            delete w;
+            conocidas = entrada;
+            completos++;
+            return primera;
+        }
+    }
+
+    if (factor <= 1 || bucle.sentencias * factor > MAX_SENTENCIAS) return next(it);
+    long resta = (long) (factor - 1) * bucle.paso;
+    if (!cabeEnInt(resta)) return next(it);
+    // while i < n - (factor-1)*paso do <factor copias> endwhile;
+    // y el bucle original recorre las vueltas que sobran
+    Exp* nuevoLimite;
+    if (esConstante(bucle.limite, limite)) {
+        if (!cabeEnInt(limite - resta)) return next(it);
+        nuevoLimite = new NumberExp((int) (limite - resta));
+    } else {
+        nuevoLimite = new BinaryExp(clonar(bucle.limite), new NumberExp((int) resta), MINUS_OP);
+        nuevoLimite->tipo = TIPO_INT;
+    }
+    StatementList* copias = new StatementList();
+    for (int c = 0; c < factor; c++) {
+        for (auto s : w->b->slist->stms) copias->add(clonar(s));
+    }
+    IdentifierExp* variable = new IdentifierExp(bucle.variable);
+    variable->tipo = TIPO_INT;
+    BinaryExp* condicion = new BinaryExp(variable, nuevoLimite, bucle.op);
+    condicion->tipo = TIPO_BOOL;
+    WhileStatement* principal = new WhileStatement(condicion, new Body(new VarDecList(), copias));
+    principal->sitio = w->sitio;
+    principal->linea = w->linea;
+    principal->columna = w->columna;
+    TRAZA(TRAZA_INFO, "optimizador: while de " << bucle.variable << " desenrollado x" << factor);
+    stms.insert(it, principal);
+    generados.insert(principal);
+    generados.insert(w);
+    desenrollados++;
+    return next(it);
+}
+
+// Factor de desenrollado de w; 0 si el perfil dice que nunca se ejecutó
+// (tampoco se desenrolla entero). Con perfil se usa la mayor potencia de 2
+// que no pase de la mitad de las vueltas medias por entrada, con tope en
+// --unroll=N si se dio o en 8.
+int Optimizer::factorDe(WhileStatement* w) const {
+    if (!perfilFuncion || w->sitio < 0) return opciones.desenrollar;
+    CuentasSitio c = perfilFuncion->sitio(w->sitio);
+    if (c[0] == 0) return 0;
+    long media = c[1] / c[0];
+    int tope = opciones.desenrollar > 1 ? opciones.desenrollar : 8;
+    int factor = 1;
+    while (factor * 2 <= tope && factor * 4 <= media) factor *= 2;
+    return factor;
+}
+
+// Un while contado: la condición es `i < n` o `i <= n` con i local y n
+// constante o invariante, la última sentencia del cuerpo es la única
+// asignación a i y suma un paso constante positivo. Solo se desenrollan los
+// bucles más internos y sin declaraciones (cada copia las volvería a
+// ubicar en otro lugar del marco).
+bool Optimizer::reconocer(WhileStatement* w, Bucle& bucle) {
+    if (w->condition->kind != BINARY_EXP) return false;
+    BinaryExp* cond = static_cast<BinaryExp*>(w->condition);
+    if ((cond->op != LT_OP && cond->op != LE_OP) || cond->left->kind != IDENTIFIER_EXP) return false;
+    string i = static_cast<IdentifierExp*>(cond->left)->name;
+    if (!locales.count(i)) return false;
+
+    Resumen r;
+    resumir(w->b, r);
+    if (r.declaraciones || r.bucles || w->b->slist->stms.empty()) return false;
+
+    if (cond->right->kind == IDENTIFIER_EXP) {
+        const string& n = static_cast<IdentifierExp*>(cond->right)->name;
+        if (n == i || r.asignadas.count(n)) return false;
+        if (!locales.count(n) && r.llamadas) return false;
+    } else if (cond->right->kind != NUMBER_EXP) {
+        return false;
+    }
+
+    auto veces = r.asignadas.find(i);
+    if (veces == r.asignadas.end() || veces->second != 1) return false;
+    Stm* ultima = w->b->slist->stms.back();
+    if (ultima->kind != ASSIGN_STM) return false;
+    AssignStatement* inc = static_cast<AssignStatement*>(ultima);
+    if (inc->id != i || inc->rhs->kind != BINARY_EXP) return false;
+    BinaryExp* suma = static_cast<BinaryExp*>(inc->rhs);
+    if (suma->op != PLUS_OP) return false;
+    Exp* var = suma->left;
+    Exp* paso = suma->right;
+    if (var->kind == NUMBER_EXP) swap(var, paso);
+    if (var->kind != IDENTIFIER_EXP || static_cast<IdentifierExp*>(var)->name != i) return false;
+    if (paso->kind != NUMBER_EXP || static_cast<NumberExp*>(paso)->value <= 0) return false;
+
+    bucle.variable = i;
+    bucle.op = cond->op;
+    bucle.limite = cond->right;
+    bucle.paso = static_cast<NumberExp*>(paso)->value;
+    bucle.sentencias = r.sentencias;
+    return true;
+}
+
+// Topes de BucleVectorial: GenCodeVisitor tiene 6 registros para las bases
+// de los arreglos y %xmm3..%xmm15 para los invariantes.
+static const int MAX_ARREGLOS_VECTORIALES = 6;
+static const int MAX_INVARIANTES_VECTORIALES = 13;
+
+// Un while contado de paso 1 cuyo cuerpo es una sola asignación, sin
+// llamadas, de una de las formas de BucleVectorial. La multiplicación no
+// entra: no hay producto empaquetado de 64 bits ni en SSE2 ni en AVX2. Las
+// sumas y restas de enteros son exactas módulo 2^64, así que reordenar una
+// reducción por carriles no cambia el resultado.
+BucleVectorial* Optimizer::vectorial(WhileStatement* w, const Bucle& bucle) {
+    if (opciones.vectorizar < 2 || bucle.paso != 1 || bucle.sentencias != 2) return nullptr;
+    Stm* s = w->b->slist->stms.front();
+    if (s->kind != ASSIGN_STM) return nullptr;
+    AssignStatement* a = static_cast<AssignStatement*>(s);
+    if (contieneLlamadas(a->rhs)) return nullptr;
+    auto indiceDelBucle = [&](Exp* e) {
+        return e->kind == IDENTIFIER_EXP && static_cast<IdentifierExp*>(e)->name == bucle.variable;
+    };
+
+    BucleVectorial v;
+    v.ancho = opciones.vectorizar;
+    v.variable = bucle.variable;
+    if (a->indice) {
+        if (!indiceDelBucle(a->indice)) return nullptr;
+        v.destino = a->id;
+    } else {
+        if (a->id == bucle.variable) return nullptr;
+        v.acumulador = a->id;
+    }
+
+    // t0 ± t1 ± ... se parsea como ((t0 ± t1) ± t2) ...: se baja por la
+    // izquierda juntando los términos del último al primero
+    vector<pair<Exp*, bool>> terminos;
+    Exp* e = a->rhs;
+    while (e->kind == BINARY_EXP) {
+        BinaryExp* b = static_cast<BinaryExp*>(e);
+        if (b->op != PLUS_OP && b->op != MINUS_OP) return nullptr;
+        terminos.push_back({b->right, b->op == MINUS_OP});
+        e = b->left;
+    }
+    terminos.push_back({e, false});
+    if (!v.acumulador.empty()) {
+        // acumulador = acumulador ± ...
+        if (e->kind != IDENTIFIER_EXP || static_cast<IdentifierExp*>(e)->name != v.acumulador) return nullptr;
+        terminos.pop_back();
+    }
+
+    unordered_set<string> arreglos;
+    if (!v.destino.empty()) arreglos.insert(v.destino);
+    int invariantes = 0;
+    Resumen r;
+    resumir(w->b, r);
+    for (auto t = terminos.rbegin(); t != terminos.rend(); ++t) {
+        BucleVectorial::Termino termino{BucleVectorial::Termino::CONSTANTE, "", 0, t->second};
+        Exp* x = t->first;
+        if (x->kind == INDEX_EXP) {
+            IndexExp* elemento = static_cast<IndexExp*>(x);
+            if (!indiceDelBucle(elemento->indice)) return nullptr;
+            termino.clase = BucleVectorial::Termino::ELEMENTO;
+            termino.nombre = elemento->nombre;
+            arreglos.insert(elemento->nombre);
+        } else if (x->kind == IDENTIFIER_EXP) {
+            // ni i ni el acumulador ni nada que cambie dentro del bucle
+            const string& nombre = static_cast<IdentifierExp*>(x)->name;
+            if (r.asignadas.count(nombre)) return nullptr;
+            termino.clase = BucleVectorial::Termino::VARIABLE;
+            termino.nombre = nombre;
+            invariantes++;
+        } else if (x->kind == NUMBER_EXP) {
+            termino.valor = static_cast<NumberExp*>(x)->value;
+            invariantes++;
+        } else {
+            return nullptr;
+        }
+        v.terminos.push_back(termino);
+    }
+    if ((int) arreglos.size() > MAX_ARREGLOS_VECTORIALES || invariantes > MAX_INVARIANTES_VECTORIALES) return nullptr;
+    return new BucleVectorial(v);
+}
+
+// Reemplaza las locales conocidas por su valor y pliega las operaciones
+// entre constantes, de las hojas hacia la raíz y sin recursión. Solo se
+// pliega si el resultado cabe en un NumberExp (y nunca una división por
+// cero, que se deja fallar en ejecución).
+Exp* Optimizer::plegar(Exp* raiz, const Constantes& conocidas) {
+    struct Marco {
+        Exp** ranura;
+        bool hijos;
+    };
+    Exp* resultado = raiz;
+    vector<Marco> pila = {{&resultado, false}};
+    while (!pila.empty()) {
+        Marco& m = pila.back();
+        Exp** ranura = m.ranura;
+        Exp* e = *ranura;
+        if (!m.hijos) {
+            m.hijos = true;
+            if (e->kind == BINARY_EXP) {
+                BinaryExp* b = static_cast<BinaryExp*>(e);
+                pila.push_back({&b->left, false});
+                pila.push_back({&b->right, false});
+                continue;
+            }
+            if (e->kind == FCALL_EXP) {
+                for (auto& arg : static_cast<FCallExp*>(e)->argumentos) pila.push_back({&arg, false});
+                continue;
+            }
+            if (e->kind == INDEX_EXP) {
+                pila.push_back({&static_cast<IndexExp*>(e)->indice, false});
+                continue;
+            }
+            if (e->kind == IF_EXP) {
+                IfExp* x = static_cast<IfExp*>(e);
+                pila.push_back({&x->condicion, false});
+                pila.push_back({&x->entonces, false});
+                pila.push_back({&x->sino, false});
+                continue;
+            }
+        }
+        pila.pop_back();
+        if (e->kind == IDENTIFIER_EXP) {
+            const string& nombre = static_cast<IdentifierExp*>(e)->name;
+            auto c = locales.count(nombre) ? conocidas.find(nombre) : conocidas.end();
+            if (c != conocidas.end()) {
+                *ranura = constante(c->second, e->tipo);
+                delete e;
+                plegadas++;
+            }
+        } else if (e->kind == BINARY_EXP) {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            long x, y, v;
+            if (!esConstante(b->left, x) || !esConstante(b->right, y)) continue;
+            switch (b->op) {
+                case PLUS_OP: v = x + y; break;
+                case MINUS_OP: v = x - y; break;
+                case MUL_OP: v = x * y; break;
+                case DIV_OP:
+                    if (y == 0) continue;
+                    v = x / y;
+                    break;
+                case LT_OP: v = x < y; break;
+                case LE_OP: v = x <= y; break;
+                case EQ_OP: v = x == y; break;
+                default: continue;
+            }
+            if (!cabeEnInt(v)) continue;
+            *ranura = constante(v, e->tipo);
+            delete e;
+            plegadas++;
+        } else if (e->kind == IF_EXP) {
+            // con la condición constante queda la rama elegida; la otra no
+            // se habría evaluado
+            IfExp* x = static_cast<IfExp*>(e);
+            long c;
+            if (!esConstante(x->condicion, c)) continue;
+            Exp*& elegida = c ? x->entonces : x->sino;
+            *ranura = elegida;
+            elegida = nullptr;
+            delete e;
+            plegadas++;
+        }
+    }
+    return resultado;
+}
+
+// Recorre la lista hacia atrás: `muertas` son las locales que se vuelven
+// a asignar (o que la función ya no lee porque termina) antes de cualquier
+// lectura. Un if o un while cortan el análisis.
+void Optimizer::eliminarAsignacionesMuertas(list<Stm*>& stms, bool finDeFuncion) {
+    unordered_set<string> muertas;
+    if (finDeFuncion) muertas = locales;
+    auto leer = [&](Exp* e) {
+        recorrer(e, [&](Exp* n) {
+            if (n->kind == IDENTIFIER_EXP) muertas.erase(static_cast<IdentifierExp*>(n)->name);
+        });
+    };
+    for (auto it = stms.end(); it != stms.begin(); ) {
+        --it;
+        Stm* s = *it;
+        if (s->kind == ASSIGN_STM) {
+            AssignStatement* a = static_cast<AssignStatement*>(s);
+            if (a->indice) {
+                leer(a->indice);
+                leer(a->rhs);
+                continue;
+            }
+            if (muertas.count(a->id) && !contieneLlamadas(a->rhs)) {
+                delete a;
+                it = stms.erase(it);
+                continue;
+            }
+            if (locales.count(a->id)) muertas.insert(a->id);
+            leer(a->rhs);
+        } else if (s->kind == PRINT_STM) {
+            leer(static_cast<PrintStatement*>(s)->e);
+        } else if (s->kind == RETURN_STM) {
+            muertas = locales;
+            if (static_cast<ReturnStatement*>(s)->e) leer(static_cast<ReturnStatement*>(s)->e);
+        } else {
+            muertas.clear();
+        }
+    }
+}
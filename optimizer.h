@@ -0,0 +1,75 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "exp.h"
+#include "perfil.h"
+using namespace std;
+
+struct OpcionesOptimizacion {
+    // factor de desenrollado de los while contados (0 o 1: no se desenrolla)
+    int desenrollar = 0;
+    // un while contado cuyas vueltas se conocen y no pasan de este número
+    // se reemplaza por copias de su cuerpo
+    int vueltasCompleto = 16;
+    // --profile-use: el factor de cada bucle sale de sus vueltas medidas y
+    // los que no se ejecutaron no se desenrollan
+    const Perfil* perfil = nullptr;
+    // elementos por vector de los bucles vectorizados: 2 con SSE2 (-O1), 4
+    // con AVX2 (-mavx2); 0 no vectoriza
+    int vectorizar = 0;
+    bool activa() const { return desenrollar > 1 || vectorizar > 1 || perfil != nullptr; }
+    // distingue en la cache incremental el código generado con otras opciones
+    uint64_t huella() const;
+};
+
+// Pasada sobre el AST de una función, antes del etiquetado: propaga y
+// pliega constantes de variables locales, vectoriza o desenrolla los while
+// contados (`while i < n do ... i = i + c endwhile`), descarta la rama
+// que no toma un if de condición constante y elimina las asignaciones que
+// se sobrescriben antes de leerse. Trabaja función por función, así que
+// sirve igual en la compilación por función, la completa y la incremental.
+class Optimizer {
+public:
+    explicit Optimizer(const OpcionesOptimizacion& opciones) : opciones(opciones) {}
+    // globales: los nombres que GenCodeVisitor trata como globales; nunca
+    // se propagan porque una llamada puede modificarlas
+    void optimizar(FunDec* f, const unordered_map<string, bool>& globales);
+    long desenrollados = 0;   // while desenrollados con un bucle de resto
+    long completos = 0;       // while reemplazados por copias de su cuerpo
+    long plegadas = 0;        // expresiones reemplazadas por una constante
+    long vectorizados = 0;    // while con un BucleVectorial
+    long ramasEliminadas = 0; // if de condición constante reducidos a una rama
+private:
+    typedef unordered_map<string, int> Constantes;
+    struct Bucle {
+        string variable;
+        BinaryOp op;      // LT_OP o LE_OP
+        Exp* limite;      // NumberExp o IdentifierExp invariante
+        int paso;         // constante positiva
+        int sentencias;
+    };
+    void declarar(Body* b);
+    void optimizarBloque(Body* b, Constantes& conocidas, bool finDeFuncion = false);
+    list<Stm*>::iterator podar(list<Stm*>& stms, list<Stm*>::iterator it, bool entonces, Constantes& conocidas);
+    list<Stm*>::iterator optimizarWhile(list<Stm*>& stms, list<Stm*>::iterator it, Constantes& conocidas);
+    bool reconocer(WhileStatement* w, Bucle& bucle);
+    BucleVectorial* vectorial(WhileStatement* w, const Bucle& bucle);
+    int factorDe(WhileStatement* w) const;
+    Exp* plegar(Exp* raiz, const Constantes& conocidas);
+    void eliminarAsignacionesMuertas(list<Stm*>& stms, bool finDeFuncion);
+
+    OpcionesOptimizacion opciones;
+    // variables locales; los arreglos no, porque no se propagan ni se
+    // eliminan sus asignaciones
+    unordered_set<string> locales;
+    // bucles ya producidos por el desenrollado; no se vuelven a desenrollar
+    unordered_set<Stm*> generados;
+    const PerfilFuncion* perfilFuncion = nullptr;
+};
+
+#endif // OPTIMIZER_H
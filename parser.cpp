@@ -1,302 +1,618 @@
-#include <iostream>
-#include <stdexcept>
-#include "token.h"
-#include "scanner.h"
-#include "exp.h"
-#include "parser.h"
-
-using namespace std;
-
-bool Parser::match(Token::Type ttype) {
-    if (check(ttype)) {
-        advance();
-        return true;
-    }
-    return false;
-}
-
-bool Parser::check(Token::Type ttype) {
-    if (isAtEnd()) return false;
-    return current->type == ttype;
-}
-
-bool Parser::advance() {
-    if (!isAtEnd()) {
-        Token* temp = current;
-        if (previous) delete previous;
-        current = scanner->nextToken();
-        previous = temp;
-        if (check(Token::ERR)) {
-            cout << "Error de análisis, carácter no reconocido: " << current->text << endl;
-            exit(1);
-        }
-        return true;
-    }
-    return false;
-}
-
-bool Parser::isAtEnd() {
-    return (current->type == Token::END);
-}
-
-Parser::Parser(Scanner* sc):scanner(sc) {
-    previous = nullptr;
-    current = scanner->nextToken();
-    if (current->type == Token::ERR) {
-        cout << "Error en el primer token: " << current->text << endl;
-        exit(1);
-    }
-}
-
-VarDec* Parser::parseVarDec() {
-    VarDec* vd = nullptr;
-    if (match(Token::VAR)) {
-        if (!match(Token::ID)) {
-            cout << "Error: se esperaba un identificador después de 'var'." << endl;
-            exit(1);
-        }
-        string type = previous->text;
-        list<string> ids;
-        if (!match(Token::ID)) {
-            cout << "Error: se esperaba un identificador después de 'var'." << endl;
-            exit(1);
-        }
-        ids.push_back(previous->text);
-        while (match(Token::COMA)) {
-            if (!match(Token::ID)) {
-                cout << "Error: se esperaba un identificador después de ','." << endl;
-                exit(1);
-            }
-            ids.push_back(previous->text);
-        }
-        if (!match(Token::PC)) {
-            cout << "Error: se esperaba un ';' al final de la declaración." << endl;
-            exit(1);
-        }
-        vd = new VarDec(type, ids);
-    }
-    return vd;
-}
-
-VarDecList* Parser::parseVarDecList() {
-    VarDecList* vdl = new VarDecList();
-    VarDec* aux = parseVarDec();
-    while (aux != nullptr) {
-        vdl->add(aux);
-        aux = parseVarDec();
-    }
-    return vdl;
-}
-
-StatementList* Parser::parseStatementList() {
-    StatementList* sl = new StatementList();
-    sl->add(parseStatement());
-    while (match(Token::PC)) {
-        sl->add(parseStatement());
-    }
-    return sl;
-}
-
-Body* Parser::parseBody() {
-    VarDecList* vdl = parseVarDecList();
-    StatementList* sl = parseStatementList();
-    return new Body(vdl, sl);
-}
-
-Program* Parser::parseProgram() {
-    Program* p = new Program();
-    p->vardecs = parseVarDecList();
-    p->fundecs = parseFunDecList();
-    return p;
-}
-
-FunDecList* Parser::parseFunDecList() {
-    FunDecList* vdl = new FunDecList();
-    FunDec* aux = parseFunDec();
-    while (aux != nullptr) {
-        vdl->add(aux);
-        aux = parseFunDec();
-    }
-    return vdl;
-}
-
-FunDec* Parser::parseFunDec() {
-    FunDec* vd = nullptr;
-    if (match(Token::FUN)) {
-        FunDec* fu = new FunDec();
-        match(Token::ID);
-        fu->tipo = previous->text;
-        match(Token::ID);
-        fu->nombre = previous->text;
-        match(Token::PI);
-        while (match(Token::ID)) {
-            fu->tipos.push_back(previous->text);
-            match(Token::ID);
-            fu->parametros.push_back(previous->text);
-            if (!match(Token::COMA)) break;
-        }
-        match(Token::PD);
-        fu->cuerpo = parseBody();
-        match(Token::ENDFUN);
-        vd = fu;
-    }
-    return vd;
-}
-
-Stm* Parser::parseStatement() {
-    Stm* s = nullptr;
-    Exp* e = nullptr;
-    Body* tb = nullptr;
-    Body* fb = nullptr;
-
-    if (current == nullptr) {
-        cout << "Error: Token actual es NULL" << endl;
-        exit(1);
-    }
-    if (match(Token::ID)) {
-        string lex = previous->text;
-        if (!match(Token::ASSIGN)) {
-            cout << "Error: se esperaba un '=' después del identificador." << endl;
-            exit(1);
-        }
-        e = parseCExp();
-        s = new AssignStatement(lex, e);
-    } else if (match(Token::PRINT)) {
-        if (!match(Token::PI)) {
-            cout << "Error: se esperaba un '(' después de 'print'." << endl;
-            exit(1);
-        }
-        e = parseCExp();
-        if (!match(Token::PD)) {
-            cout << "Error: se esperaba un ')' después de la expresión." << endl;
-            exit(1);
-        }
-        s = new PrintStatement(e);
-    }
-    else if (match(Token::RETURN)) {
-        ReturnStatement* rs = new ReturnStatement();
-        if (!match(Token::PI)) {
-            cout << "Error: se esperaba '(' después de 'return'." << endl;
-            exit(1);
-        }
-        if (check(Token::PD)) {
-            advance();
-            rs->e = nullptr;
-        } else {
-            rs->e = parseCExp();
-            if (!match(Token::PD)) {
-                cout << "Error: se esperaba ')' después de la expresión de return." << endl;
-                exit(1);
-            }
-        }
-        return rs;
-    } else if (match(Token::IF)) {
-        e = parseCExp();
-        if (!match(Token::THEN)) {
-            cout << "Error: se esperaba 'then' después de la expresión." << endl;
-            exit(1);
-        }
-        tb = parseBody();
-        if (match(Token::ELSE)) {
-            fb = parseBody();
-        }
-        if (!match(Token::ENDIF)) {
-            cout << "Error: se esperaba 'endif' al final de la declaración de if." << endl;
-            exit(1);
-        }
-        s = new IfStatement(e, tb, fb);
-    }
-    else if (match(Token::WHILE)) {
-        e = parseCExp();
-        if (!match(Token::DO)) {
-            cout << "Error: se esperaba 'do' después de la expresión." << endl;
-            exit(1);
-        }
-        tb = parseBody();
-        if (!match(Token::ENDWHILE)) {
-            cout << "Error: se esperaba 'endwhile' al final de la declaración." << endl;
-            exit(1);
-        }
-        s = new WhileStatement(e, tb);
-    }
-    else {
-        cout << "Error: Se esperaba un identificador, 'print', o estructura válida, pero se encontró: " << *current << endl;
-        exit(1);
-    }
-    return s;
-}
-
-Exp* Parser::parseCExp(){
-    Exp* left = parseExpression();
-    if (match(Token::LT) || match(Token::LE) || match(Token::EQ)){
-        BinaryOp op;
-        if (previous->type == Token::LT){
-            op = LT_OP;
-        } else if (previous->type == Token::LE){
-            op = LE_OP;
-        } else {
-            op = EQ_OP;
-        }
-        Exp* right = parseExpression();
-        left = new BinaryExp(left, right, op);
-    }
-    return left;
-}
-
-Exp* Parser::parseExpression() {
-    Exp* left = parseTerm();
-    while (match(Token::PLUS) || match(Token::MINUS)) {
-        BinaryOp op = (previous->type == Token::PLUS) ? PLUS_OP : MINUS_OP;
-        Exp* right = parseTerm();
-        left = new BinaryExp(left, right, op);
-    }
-    return left;
-}
-
-Exp* Parser::parseTerm() {
-    Exp* left = parseFactor();
-    while (match(Token::MUL) || match(Token::DIV)) {
-        BinaryOp op = (previous->type == Token::MUL) ? MUL_OP : DIV_OP;
-        Exp* right = parseFactor();
-        left = new BinaryExp(left, right, op);
-    }
-    return left;
-}
-
-Exp* Parser::parseFactor() {
-    if (match(Token::TRUE)){
-        return new BoolExp(1);
-    } else if (match(Token::FALSE)){ 
-        return new BoolExp(0); 
-    } else if (match(Token::NUM)) {
-        return new NumberExp(stoi(previous->text));
-    } else if (match(Token::ID)) {
-        string nombre = previous->text;
-        if (match(Token::PI)) {
-            FCallExp* fc = new FCallExp();
-            vector<Exp*> lista;
-            lista.push_back(parseCExp());
-            while (match(Token::COMA)) {
-                lista.push_back(parseCExp());
-            }
-            if (!match(Token::PD)) {
-                cout << "Error: se esperaba un ')' después de la lista de argumentos." << endl;
-                exit(1);
-            }
-            fc->argumentos = lista;
-            fc->nombre = nombre;
-            return fc;
-        } else {
-            return new IdentifierExp(nombre);
-        }
-    } else if (match(Token::PI)){
-        Exp* e = parseCExp();
-        if (!match(Token::PD)){
-            cout << "Falta parentesis derecho" << endl;
-            exit(0);
-        }
-        return e;
-    }
-    cout << "Error: se esperaba un número o identificador." << endl;
-    exit(0);
-}
\ No newline at end of file
+#include <iostream>
+#include <stdexcept>
+#include "token.h"
+#include "scanner.h"
+#include "exp.h"
+#include "parser.h"
+#include "trace.h"
+
+using namespace std;
+
+// Tope de elementos de un arreglo: 128 MiB, y los desplazamientos en el
+// marco siguen cabiendo en 32 bits.
+static const long MAX_ELEMENTOS = 1 << 24;
+
+bool Parser::match(Token::Type ttype) {
+    if (check(ttype)) {
+        advance();
+        return true;
+    }
+    return false;
+}
+
+bool Parser::check(Token::Type ttype) {
+    if (isAtEnd()) return false;
+    return current->type == ttype;
+}
+
+bool Parser::advance() {
+    if (!isAtEnd()) {
+        Token* temp = current;
+        if (previous) delete previous;
+        current = siguienteValido();
+        previous = temp;
+        TRAZA(TRAZA_DEBUG, "parser: token '" << current->text << "'");
+        return true;
+    }
+    return false;
+}
+
+bool Parser::isAtEnd() {
+    return (current->type == Token::END);
+}
+
+// Los caracteres no reconocidos se reportan y se saltan; el parser nunca
+// ve un token ERR.
+Token* Parser::siguienteValido() {
+    Token* tok = scanner->nextToken();
+    while (tok->type == Token::ERR) {
+        TRAZA(TRAZA_ERROR, "parser: token ERR '" << tok->text << "'");
+        diagnosticos.push_back({tok->linea, tok->columna, "carácter no reconocido: " + tok->text});
+        delete tok;
+        tok = scanner->nextToken();
+    }
+    return tok;
+}
+
+void Parser::error(const string& mensaje) {
+    diagnosticos.push_back({current->linea, current->columna, mensaje});
+    throw ErrorSintaxis(mensaje);
+}
+
+bool Parser::cierraBloque() {
+    return check(Token::ENDWHILE) || check(Token::ENDFOR) || check(Token::ENDIF) || check(Token::ELSE) ||
+           check(Token::ENDFUN) || check(Token::FUN);
+}
+
+// Modo pánico: descarta tokens hasta un punto de sincronización. El ';' se
+// consume (la siguiente sentencia empieza después); los cierres de bloque
+// se dejan para que los reconozca la construcción que los espera.
+// profundidad > 0 indica que el error ocurrió en la cabecera de un if/while/for,
+// cuyo cierre también hay que descartar.
+void Parser::sincronizar(int profundidad) {
+    while (!isAtEnd()) {
+        switch (current->type) {
+            case Token::ENDFUN:
+            case Token::FUN:
+                return;
+            case Token::IF:
+            case Token::WHILE:
+            case Token::FOR:
+                profundidad++;
+                advance();
+                break;
+            case Token::ENDIF:
+            case Token::ENDWHILE:
+            case Token::ENDFOR:
+                if (profundidad == 0) return;
+                profundidad--;
+                advance();
+                break;
+            case Token::ELSE:
+                if (profundidad == 0) return;
+                advance();
+                break;
+            case Token::PC:
+                advance();
+                if (profundidad == 0) return;
+                break;
+            default:
+                advance();
+        }
+    }
+}
+
+Parser::Parser(Scanner* sc):scanner(sc) {
+    previous = nullptr;
+    current = siguienteValido();
+}
+
+Parser::~Parser() {
+    delete previous;
+    delete current;
+}
+
+VarDec* Parser::parseVarDec() {
+    VarDec* vd = nullptr;
+    if (match(Token::VAR)) {
+        int linea = previous->linea, columna = previous->columna;
+        if (!match(Token::ID)) {
+            error("se esperaba un tipo después de 'var'.");
+        }
+        string type = previous->text;
+        int longitud = 0;
+        if (match(Token::CI)) {
+            if (!match(Token::NUM)) {
+                error("se esperaba la cantidad de elementos del arreglo.");
+            }
+            long n = previous->text.size() <= 9 ? stol(previous->text) : 0;
+            if (n < 1 || n > MAX_ELEMENTOS) {
+                error("un arreglo tiene entre 1 y " + to_string(MAX_ELEMENTOS) + " elementos.");
+            }
+            longitud = (int) n;
+            if (!match(Token::CD)) {
+                error("se esperaba un ']' después de la cantidad de elementos.");
+            }
+        }
+        list<string> ids;
+        if (!match(Token::ID)) {
+            error("se esperaba un identificador después del tipo.");
+        }
+        ids.push_back(previous->text);
+        while (match(Token::COMA)) {
+            if (!match(Token::ID)) {
+                error("se esperaba un identificador después de ','.");
+            }
+            ids.push_back(previous->text);
+        }
+        if (!match(Token::PC)) {
+            error("se esperaba un ';' al final de la declaración.");
+        }
+        vd = new VarDec(type, ids);
+        vd->longitud = longitud;
+        vd->linea = linea;
+        vd->columna = columna;
+    }
+    return vd;
+}
+
+VarDecList* Parser::parseVarDecList() {
+    VarDecList* vdl = new VarDecList();
+    while (check(Token::VAR)) {
+        try {
+            vdl->add(parseVarDec());
+        } catch (const ErrorSintaxis&) {
+            sincronizar(0);
+        }
+    }
+    return vdl;
+}
+
+StatementList* Parser::parseStatementList() {
+    StatementList* sl = new StatementList();
+    while (true) {
+        Token::Type inicio = current->type;
+        try {
+            sl->add(parseStatement());
+            if (match(Token::PC)) continue;
+            if (isAtEnd() || cierraBloque()) break;
+            error("se esperaba ';' entre sentencias, pero se encontró '" + current->text + "'.");
+        } catch (const ErrorSintaxis&) {
+            // si sincronizar() se detuvo en un ';' lo consumió y la lista sigue
+            sincronizar(inicio == Token::IF || inicio == Token::WHILE || inicio == Token::FOR ? 1 : 0);
+            if (isAtEnd() || cierraBloque()) break;
+        }
+    }
+    return sl;
+}
+
+Body* Parser::parseBody() {
+    VarDecList* vdl = parseVarDecList();
+    StatementList* sl = parseStatementList();
+    return new Body(vdl, sl);
+}
+
+Program* Parser::parseProgram() {
+    Program* p = new Program();
+    p->vardecs = parseVarDecList();
+    p->fundecs = new FunDecList();
+    while (FunDec* f = parseSiguienteFunDec()) {
+        p->fundecs->add(f);
+    }
+    return p;
+}
+
+FunDec* Parser::parseSiguienteFunDec() {
+    while (!isAtEnd()) {
+        if (!check(Token::FUN)) {
+            diagnosticos.push_back({current->linea, current->columna,
+                                    "se esperaba 'fun', pero se encontró '" + current->text + "'."});
+            do {
+                advance();
+            } while (!isAtEnd() && !check(Token::FUN));
+            continue;
+        }
+        FunDec* f = parseFunDec();
+        if (f != nullptr) return f;
+    }
+    return nullptr;
+}
+
+FunDecList* Parser::parseFunDecList() {
+    FunDecList* vdl = new FunDecList();
+    while (check(Token::FUN)) {
+        FunDec* f = parseFunDec();
+        if (f != nullptr) vdl->add(f);
+    }
+    return vdl;
+}
+
+FunDec* Parser::parseFunDec() {
+    if (!check(Token::FUN)) return nullptr;
+    try {
+        return funDec();
+    } catch (const ErrorSintaxis&) {
+        while (!isAtEnd() && !check(Token::ENDFUN) && !check(Token::FUN)) advance();
+        match(Token::ENDFUN);
+        return nullptr;
+    }
+}
+
+FunDec* Parser::funDec() {
+    match(Token::FUN);
+    FunDec* fu = new FunDec();
+    fu->linea = previous->linea;
+    fu->columna = previous->columna;
+    try {
+        if (!match(Token::ID)) error("se esperaba el tipo de retorno después de 'fun'.");
+        fu->tipo = previous->text;
+        if (!match(Token::ID)) error("se esperaba el nombre de la función.");
+        fu->nombre = previous->text;
+        TRAZA(TRAZA_INFO, "parser: funcion " << fu->nombre);
+        if (!match(Token::PI)) error("se esperaba '(' después del nombre de la función.");
+        while (match(Token::ID)) {
+            fu->tipos.push_back(previous->text);
+            if (!match(Token::ID)) error("se esperaba el nombre del parámetro.");
+            fu->parametros.push_back(previous->text);
+            if (!match(Token::COMA)) break;
+        }
+        if (!match(Token::PD)) error("se esperaba ')' al final de los parámetros.");
+        fu->cuerpo = parseBody();
+        if (!match(Token::ENDFUN)) error("se esperaba 'endfun' al final de la función.");
+    } catch (const ErrorSintaxis&) {
+        delete fu;
+        throw;
+    }
+    return fu;
+}
+
+Stm* Parser::parseStatement() {
+    Stm* s = nullptr;
+    Exp* e = nullptr;
+    Body* tb = nullptr;
+    Body* fb = nullptr;
+    int linea = current->linea, columna = current->columna;
+
+    if (match(Token::ID)) {
+        string lex = previous->text;
+        Exp* indice = nullptr;
+        if (match(Token::CI)) {
+            indice = parseCExp();
+            if (!match(Token::CD)) {
+                delete indice;
+                error("se esperaba un ']' después del índice.");
+            }
+        }
+        if (!match(Token::ASSIGN)) {
+            delete indice;
+            error("se esperaba un '=' después del identificador.");
+        }
+        try {
+            e = parseCExp();
+        } catch (const ErrorSintaxis&) {
+            delete indice;
+            throw;
+        }
+        AssignStatement* a = new AssignStatement(lex, e);
+        a->indice = indice;
+        s = a;
+    } else if (match(Token::PRINT)) {
+        if (!match(Token::PI)) {
+            error("se esperaba un '(' después de 'print'.");
+        }
+        e = parseCExp();
+        if (!match(Token::PD)) {
+            delete e;
+            error("se esperaba un ')' después de la expresión.");
+        }
+        s = new PrintStatement(e);
+    }
+    else if (match(Token::RETURN)) {
+        if (!match(Token::PI)) {
+            error("se esperaba '(' después de 'return'.");
+        }
+        if (check(Token::PD)) {
+            advance();
+        } else {
+            e = parseCExp();
+            if (!match(Token::PD)) {
+                delete e;
+                error("se esperaba ')' después de la expresión de return.");
+            }
+        }
+        ReturnStatement* rs = new ReturnStatement();
+        rs->e = e;
+        s = rs;
+    } else if (match(Token::IF)) {
+        e = parseCExp();
+        if (!match(Token::THEN)) {
+            delete e;
+            error("se esperaba 'then' después de la expresión.");
+        }
+        tb = parseBody();
+        if (match(Token::ELSE)) {
+            fb = parseBody();
+        }
+        if (!match(Token::ENDIF)) {
+            delete e;
+            delete tb;
+            delete fb;
+            error("se esperaba 'endif' al final de la declaración de if.");
+        }
+        s = new IfStatement(e, tb, fb);
+    }
+    else if (match(Token::WHILE)) {
+        e = parseCExp();
+        if (!match(Token::DO)) {
+            delete e;
+            error("se esperaba 'do' después de la expresión.");
+        }
+        tb = parseBody();
+        if (!match(Token::ENDWHILE)) {
+            delete e;
+            delete tb;
+            error("se esperaba 'endwhile' al final de la declaración.");
+        }
+        s = new WhileStatement(e, tb);
+    }
+    else if (match(Token::FOR)) {
+        if (!match(Token::ID)) {
+            error("se esperaba la variable después de 'for'.");
+        }
+        string variable = previous->text;
+        if (!match(Token::ASSIGN)) {
+            error("se esperaba un '=' después de la variable del for.");
+        }
+        e = parseCExp();
+        if (!match(Token::COMA)) {
+            delete e;
+            error("se esperaba ',' entre los límites del for.");
+        }
+        Exp* fin;
+        try {
+            fin = parseCExp();
+        } catch (const ErrorSintaxis&) {
+            delete e;
+            throw;
+        }
+        if (!match(Token::DO)) {
+            delete e;
+            delete fin;
+            error("se esperaba 'do' después de los límites del for.");
+        }
+        tb = parseBody();
+        if (!match(Token::ENDFOR)) {
+            delete e;
+            delete fin;
+            delete tb;
+            error("se esperaba 'endfor' al final del for.");
+        }
+        s = new ForStatement(variable, e, fin, tb);
+    }
+    else {
+        error("se esperaba un identificador, 'print', o estructura válida, pero se encontró '" + current->text + "'.");
+    }
+    s->linea = linea;
+    s->columna = columna;
+    return s;
+}
+
+// Tabla de operadores binarios. Mayor precedencia liga más fuerte; las
+// comparaciones (precedencia 1) no son asociativas: una expresión admite a
+// lo sumo una en su nivel, como en la gramática
+//   CExp ::= Exp [(<|<=|==) Exp]   Exp ::= Term {(+|-) Term}   Term ::= Factor {(*|/) Factor}
+struct Operador {
+    int precedencia;
+    BinaryOp op;
+};
+
+static Operador operadorDe(Token::Type tipo) {
+    switch (tipo) {
+        case Token::LT:    return {1, LT_OP};
+        case Token::LE:    return {1, LE_OP};
+        case Token::EQ:    return {1, EQ_OP};
+        case Token::PLUS:  return {2, PLUS_OP};
+        case Token::MINUS: return {2, MINUS_OP};
+        case Token::MUL:   return {3, MUL_OP};
+        case Token::DIV:   return {3, DIV_OP};
+        default:           return {0, PLUS_OP};
+    }
+}
+
+// Cada '(', cada llamada, cada '[' de un índice y cada ifexp abre un marco
+// en una pila explícita en lugar de una llamada recursiva, así que la
+// profundidad de anidamiento no está limitada por la pila del proceso.
+struct MarcoExp {
+    enum Tipo { RAIZ, PARENTESIS, LLAMADA, INDICE, CONDICIONAL } tipo;
+    FCallExp* llamada;
+    size_t baseOperadores;
+    bool comparacion;
+    string arreglo;     // INDICE: nombre del arreglo
+    IfExp* condicional = nullptr;   // CONDICIONAL: se completa parte por parte
+};
+
+// Reduce los operadores del marco con precedencia >= minima (todos son
+// asociativos a izquierda).
+static void reducir(vector<Exp*>& operandos, vector<Operador>& operadores, size_t base, int minima) {
+    while (operadores.size() > base && operadores.back().precedencia >= minima) {
+        Exp* right = operandos.back();
+        operandos.pop_back();
+        Exp* left = operandos.back();
+        operandos.back() = new BinaryExp(left, right, operadores.back().op);
+        operadores.pop_back();
+    }
+}
+
+// Precedence climbing con pilas explícitas; construye el mismo AST que el
+// descenso recursivo por niveles y reporta los mismos errores.
+Exp* Parser::parseCExp() {
+    vector<Exp*> operandos;
+    vector<Operador> operadores;
+    vector<MarcoExp> marcos;
+    marcos.push_back({MarcoExp::RAIZ, nullptr, 0, false, ""});
+    try {
+        while (true) {
+            Exp* e;
+            switch (current->type) {
+                case Token::TRUE:
+                    advance();
+                    e = new BoolExp(1);
+                    break;
+                case Token::FALSE:
+                    advance();
+                    e = new BoolExp(0);
+                    break;
+                case Token::NUM:
+                    advance();
+                    try {
+                        e = new NumberExp(stoi(previous->text));
+                    } catch (const out_of_range&) {
+                        error("número fuera de rango: " + previous->text);
+                    }
+                    break;
+                case Token::ID:
+                    advance();
+                    if (current->type == Token::PI) {
+                        FCallExp* fc = new FCallExp();
+                        fc->nombre = previous->text;
+                        advance();
+                        marcos.push_back({MarcoExp::LLAMADA, fc, operadores.size(), false, ""});
+                        continue;
+                    }
+                    if (current->type == Token::CI) {
+                        string arreglo = previous->text;
+                        advance();
+                        marcos.push_back({MarcoExp::INDICE, nullptr, operadores.size(), false, arreglo});
+                        continue;
+                    }
+                    e = new IdentifierExp(previous->text);
+                    break;
+                case Token::PI:
+                    advance();
+                    marcos.push_back({MarcoExp::PARENTESIS, nullptr, operadores.size(), false, ""});
+                    continue;
+                case Token::IFEXP:
+                    advance();
+                    if (current->type != Token::PI) {
+                        error("se esperaba '(' después de 'ifexp'.");
+                    }
+                    advance();
+                    marcos.push_back({MarcoExp::CONDICIONAL, nullptr, operadores.size(), false, "",
+                                      new IfExp(nullptr, nullptr, nullptr)});
+                    continue;
+                default:
+                    error("se esperaba un número o identificador, pero se encontró '" + current->text + "'.");
+            }
+            operandos.push_back(e);
+
+            // después de un operando: un operador, o el cierre de uno o más marcos
+            while (true) {
+                MarcoExp& m = marcos.back();
+                Operador op = operadorDe(current->type);
+                if (op.precedencia > 0 && !(op.precedencia == 1 && m.comparacion)) {
+                    reducir(operandos, operadores, m.baseOperadores, op.precedencia);
+                    if (op.precedencia == 1) m.comparacion = true;
+                    operadores.push_back(op);
+                    advance();
+                    break;
+                }
+                reducir(operandos, operadores, m.baseOperadores, 1);
+                if (m.tipo == MarcoExp::RAIZ) {
+                    return operandos.back();
+                }
+                if (m.tipo == MarcoExp::PARENTESIS) {
+                    if (current->type != Token::PD) {
+                        error("falta paréntesis derecho.");
+                    }
+                    advance();
+                    marcos.pop_back();
+                    continue;
+                }
+                if (m.tipo == MarcoExp::INDICE) {
+                    if (current->type != Token::CD) {
+                        error("se esperaba un ']' después del índice.");
+                    }
+                    advance();
+                    operandos.back() = new IndexExp(m.arreglo, operandos.back());
+                    marcos.pop_back();
+                    continue;
+                }
+                if (m.tipo == MarcoExp::CONDICIONAL) {
+                    // ifexp(condición, entonces, sino)
+                    IfExp* x = m.condicional;
+                    Exp*& parte = !x->condicion ? x->condicion : !x->entonces ? x->entonces : x->sino;
+                    parte = operandos.back();
+                    operandos.pop_back();
+                    if (!x->sino) {
+                        if (current->type != Token::COMA) {
+                            error("se esperaba ',' entre las partes de ifexp.");
+                        }
+                        advance();
+                        m.comparacion = false;
+                        break;
+                    }
+                    if (current->type != Token::PD) {
+                        error("se esperaba ')' al final de ifexp.");
+                    }
+                    advance();
+                    operandos.push_back(x);
+                    marcos.pop_back();
+                    continue;
+                }
+                m.llamada->argumentos.push_back(operandos.back());
+                operandos.pop_back();
+                if (current->type == Token::COMA) {
+                    advance();
+                    m.comparacion = false;
+                    break;
+                }
+                if (current->type != Token::PD) {
+                    error("se esperaba un ')' después de la lista de argumentos.");
+                }
+                advance();
+                operandos.push_back(m.llamada);
+                marcos.pop_back();
+            }
+        }
+    } catch (const ErrorSintaxis&) {
+        for (auto e : operandos) delete e;
+        for (auto& m : marcos) {
+            delete m.llamada;
+            delete m.condicional;
+        }
+        throw;
+    }
+}
+
+void leerCabecera(const Token* tok, int& posicion, Cabecera& c) {
+    if (posicion < 0) return;
+    // fun <tipo> <nombre> ( <tipo> <param>, ... )
+    if (tok->type == Token::PD) posicion = -1;
+    else if (posicion == 1) c.retorno = tok->text;
+    else if (posicion == 2) c.nombre = tok->text;
+    else if (tok->type == Token::ID && posicion % 3 == 1) c.parametros.push_back(tok->text);
+    if (posicion >= 0) posicion++;
+}
+
+bool leerCabeceras(string_view fuente, vector<Cabecera>& cabeceras) {
+    Scanner scanner(fuente);
+    bool dentro = false;
+    int posicion = -1;
+    Token* tok;
+    while ((tok = scanner.nextToken())->type != Token::END) {
+        if (tok->type == Token::ERR) {
+            delete tok;
+            return false;
+        }
+        if (!dentro && tok->type == Token::FUN) {
+            dentro = true;
+            cabeceras.push_back({"", "", {}, tok->linea, tok->columna});
+            posicion = 0;
+        }
+        if (dentro) leerCabecera(tok, posicion, cabeceras.back());
+        if (tok->type == Token::ENDFUN) dentro = false;
+        delete tok;
+    }
+    delete tok;
+    return true;
+}
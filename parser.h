@@ -1,32 +1,77 @@
-#ifndef PARSER_H
-#define PARSER_H
-
-#include "scanner.h"
-#include "exp.h"
-
-class Parser {
-private:
-    Scanner* scanner;
-    Token *current, *previous;
-    bool match(Token::Type ttype);
-    bool check(Token::Type ttype);
-    bool advance();
-    bool isAtEnd();
-    list<Stm*> parseStmList();
-    Exp* parseCExp();
-    Exp* parseExpression();
-    Exp* parseTerm();
-    Exp* parseFactor();
-public:
-    Parser(Scanner* scanner);
-    Program* parseProgram();
-    Stm* parseStatement();
-    StatementList* parseStatementList();
-    VarDec* parseVarDec();
-    VarDecList* parseVarDecList();
-    Body* parseBody();
-    FunDecList* parseFunDecList();
-    FunDec* parseFunDec();
-};
-
-#endif // PARSER_H
\ No newline at end of file
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "scanner.h"
+#include "exp.h"
+
+struct Diagnostico {
+    int linea;
+    int columna;
+    std::string mensaje;
+};
+
+// Los errores de sintaxis se registran en diagnosticos y el parser se
+// recupera en modo pánico (sincroniza en ';', endwhile, endfor, endif y endfun),
+// así que un mismo Parser reporta todos los errores del fuente y nunca
+// termina el proceso.
+class Parser {
+private:
+    class ErrorSintaxis : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+    Scanner* scanner;
+    Token *current, *previous;
+    std::vector<Diagnostico> diagnosticos;
+    bool match(Token::Type ttype);
+    bool check(Token::Type ttype);
+    bool advance();
+    bool isAtEnd();
+    Token* siguienteValido();
+    [[noreturn]] void error(const std::string& mensaje);
+    bool cierraBloque();
+    void sincronizar(int profundidad);
+    FunDec* funDec();
+    Stm* parseStatement();
+    VarDec* parseVarDec();
+    Exp* parseCExp();
+public:
+    Parser(Scanner* scanner);
+    ~Parser();
+    Program* parseProgram();
+    StatementList* parseStatementList();
+    VarDecList* parseVarDecList();
+    Body* parseBody();
+    FunDecList* parseFunDecList();
+    FunDec* parseFunDec();
+    // Devuelve la siguiente función bien formada del fuente, o nullptr al
+    // llegar al final. Permite generar código función por función sin
+    // construir el Program completo.
+    FunDec* parseSiguienteFunDec();
+    bool hasErrors() const { return !diagnosticos.empty(); }
+    const std::vector<Diagnostico>& errores() const { return diagnosticos; }
+};
+
+// Firma de una función tal como aparece en su cabecera
+// (fun <tipo> <nombre>(<tipo> <param>, ...)), en la posición del 'fun'.
+struct Cabecera {
+    std::string retorno, nombre;
+    std::vector<std::string> parametros;   // tipos
+    int linea, columna;
+};
+
+// Anota en c el token tok de la cabecera. posicion cuenta los tokens desde
+// el 'fun' (0) y queda en -1 pasada la ')'.
+void leerCabecera(const Token* tok, int& posicion, Cabecera& c);
+
+// Lee solo las cabeceras de las funciones, en orden, sin parsear los
+// cuerpos. Así la compilación por función y la incremental declaran todas
+// las firmas antes de verificar la primera función. Devuelve false si el
+// scanner encuentra un error.
+bool leerCabeceras(std::string_view fuente, std::vector<Cabecera>& cabeceras);
+
+#endif // PARSER_H
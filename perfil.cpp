@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "exp.h"
+#include "perfil.h"
+
+using namespace std;
+
+// cota para no reservar memoria por un número de sitio corrupto
+static const int MAX_SITIOS = 1 << 20;
+
+CuentasSitio PerfilFuncion::sitio(int i) const {
+    if (i < 0 || i >= (int) cuentas.size()) return {0, 0};
+    return cuentas[i];
+}
+
+static void numerarLlamadas(Exp* raiz, int& siguiente) {
+    vector<Exp*> pendientes = {raiz};
+    while (!pendientes.empty()) {
+        Exp* e = pendientes.back();
+        pendientes.pop_back();
+        if (e->kind == BINARY_EXP) {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            pendientes.push_back(b->right);
+            pendientes.push_back(b->left);
+        } else if (e->kind == FCALL_EXP) {
+            FCallExp* f = static_cast<FCallExp*>(e);
+            f->sitio = siguiente++;
+            pendientes.insert(pendientes.end(), f->argumentos.rbegin(), f->argumentos.rend());
+        } else if (e->kind == INDEX_EXP) {
+            pendientes.push_back(static_cast<IndexExp*>(e)->indice);
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            pendientes.push_back(x->sino);
+            pendientes.push_back(x->entonces);
+            pendientes.push_back(x->condicion);
+        }
+    }
+}
+
+static void numerarBloque(Body* b, int& siguiente) {
+    for (auto s : b->slist->stms) {
+        switch (s->kind) {
+            case ASSIGN_STM: {
+                AssignStatement* a = static_cast<AssignStatement*>(s);
+                if (a->indice) numerarLlamadas(a->indice, siguiente);
+                numerarLlamadas(a->rhs, siguiente);
+                break;
+            }
+            case PRINT_STM:
+                numerarLlamadas(static_cast<PrintStatement*>(s)->e, siguiente); break;
+            case RETURN_STM: {
+                Exp* e = static_cast<ReturnStatement*>(s)->e;
+                if (e) numerarLlamadas(e, siguiente);
+                break;
+            }
+            case IF_STM: {
+                IfStatement* i = static_cast<IfStatement*>(s);
+                i->sitio = siguiente++;
+                numerarLlamadas(i->condition, siguiente);
+                numerarBloque(i->then, siguiente);
+                if (i->els) numerarBloque(i->els, siguiente);
+                break;
+            }
+            case WHILE_STM: {
+                WhileStatement* w = static_cast<WhileStatement*>(s);
+                w->sitio = siguiente++;
+                numerarLlamadas(w->condition, siguiente);
+                numerarBloque(w->b, siguiente);
+                break;
+            }
+            case FOR_STM: {
+                // sin contadores propios; solo sus llamadas
+                ForStatement* f = static_cast<ForStatement*>(s);
+                numerarLlamadas(f->inicio, siguiente);
+                numerarLlamadas(f->fin, siguiente);
+                numerarBloque(f->b, siguiente);
+                break;
+            }
+        }
+    }
+}
+
+void numerarSitios(FunDec* f) {
+    int siguiente = 1;
+    numerarBloque(f->cuerpo, siguiente);
+    f->sitios = siguiente;
+}
+
+// Posición de cada contador en CuentasSitio.
+static int ranura(const string& contador) {
+    if (contador == "entradas" || contador == "llamadas" || contador == "then") return 0;
+    if (contador == "else" || contador == "vueltas") return 1;
+    return -1;
+}
+
+bool Perfil::cargar(const string& ruta, string& error) {
+    ifstream in(ruta);
+    if (!in.is_open()) {
+        error = "no se pudo abrir el perfil " + ruta;
+        return false;
+    }
+    funciones.clear();
+    firma = 14695981039346656037ULL;
+    string linea;
+    int numero = 0;
+    while (getline(in, linea)) {
+        numero++;
+        if (linea.empty()) continue;
+        istringstream campos(linea);
+        string nombre, contador;
+        int sitio;
+        long cuenta;
+        if (!(campos >> nombre >> sitio >> contador >> cuenta) || sitio < 0 || sitio > MAX_SITIOS) {
+            error = ruta + ":" + to_string(numero) + ": línea de perfil inválida";
+            return false;
+        }
+        for (unsigned char c : linea) {
+            firma ^= c;
+            firma *= 1099511628211ULL;
+        }
+        PerfilFuncion& f = funciones[nombre];
+        if (contador == "sitios") {
+            f.sitios = (int) cuenta;
+            continue;
+        }
+        int r = ranura(contador);
+        if (r < 0) {
+            error = ruta + ":" + to_string(numero) + ": contador desconocido '" + contador + "'";
+            return false;
+        }
+        if (sitio >= (int) f.cuentas.size()) f.cuentas.resize(sitio + 1, {0, 0});
+        f.cuentas[sitio][r] += cuenta;
+    }
+    return true;
+}
+
+const PerfilFuncion* Perfil::funcion(const FunDec* f) const {
+    auto it = funciones.find(f->nombre);
+    if (it == funciones.end() || it->second.sitios != f->sitios) return nullptr;
+    return &it->second;
+}
+
+void Perfil::ordenar(list<FunDec*>& lista) const {
+    auto entradas = [&](FunDec* f) {
+        const PerfilFuncion* p = funcion(f);
+        return p ? p->entradas() : 0;
+    };
+    lista.sort([&](FunDec* a, FunDec* b) { return entradas(a) > entradas(b); });
+}
@@ -0,0 +1,58 @@
+#ifndef PERFIL_H
+#define PERFIL_H
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+class FunDec;
+
+// Optimización guiada por perfil.
+//
+// Cada función numera sus sitios en orden de fuente: 0 es la entrada de la
+// función y después cada if, while y llamada (numerarSitios). Con
+// --profile-generate GenCodeVisitor suma un contador en cada arista de esos
+// sitios y el programa, al terminar, escribe una línea por contador:
+//
+//     <función> <sitio> <contador> <cuenta>
+//
+// donde contador es entradas/llamadas/then/else/vueltas, más una línea
+// "<función> 0 sitios N" para reconocer las funciones que cambiaron desde
+// que se midieron. Varios perfiles concatenados se suman al cargarlos.
+// --profile-use lee ese archivo y las pasadas lo consultan por función.
+
+// Cuentas de un sitio: [0] entradas, then o llamadas; [1] else o vueltas.
+typedef array<long, 2> CuentasSitio;
+
+struct PerfilFuncion {
+    int sitios = 0;
+    vector<CuentasSitio> cuentas;
+    long entradas() const { return cuentas.empty() ? 0 : cuentas[0][0]; }
+    // cuentas de un sitio; ceros si no se numeró
+    CuentasSitio sitio(int i) const;
+};
+
+// Numera los sitios de f (deja el total en f->sitios).
+void numerarSitios(FunDec* f);
+
+class Perfil {
+public:
+    // false si no se pudo abrir o alguna línea no tiene el formato esperado
+    bool cargar(const string& ruta, string& error);
+    // nullptr si la función no está en el perfil o sus sitios ya no son
+    // los que se midieron
+    const PerfilFuncion* funcion(const FunDec* f) const;
+    // las funciones más llamadas primero; las que no se ejecutaron al final
+    void ordenar(list<FunDec*>& funciones) const;
+    // distingue en la cache incremental el código generado con otro perfil
+    uint64_t huella() const { return firma; }
+private:
+    unordered_map<string, PerfilFuncion> funciones;
+    uint64_t firma = 0;
+};
+
+#endif // PERFIL_H
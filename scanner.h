@@ -1,20 +1,39 @@
-#ifndef SCANNER_H
-#define SCANNER_H
-
-#include <string>
-#include "token.h"
-
-class Scanner {
-private:
-    std::string input;
-    int first, current;
-public:
-    Scanner(const char* in_s);
-    Token* nextToken();
-    void reset();
-    ~Scanner();
-};
-
-void test_scanner(Scanner* scanner);
-
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "token.h"
+
+class Stats;
+
+class Scanner {
+private:
+    std::string_view input;
+    int first, current;
+    int linea, inicioLinea;
+    int lineaBase, columnaBase;
+    Stats* stats = nullptr;
+    std::vector<Token*> lote;
+    size_t siguiente = 0;
+    Token* scan();
+    Token* leer();
+    void llenarLote();
+public:
+    // El scanner no copia el fuente: in_s debe vivir mientras se use.
+    Scanner(std::string_view in_s, int linea = 1, int columna = 1);
+    Token* nextToken();
+    // Con stats, nextToken lee los tokens por lotes y mide cada lote como
+    // la fase "scanner" dentro de la que esté corriendo (el parser), y
+    // cuenta los tokens que entrega. tokenStart/tokenEnd quedan adelantados.
+    void medir(Stats* s) { stats = s; }
+    void reset();
+    int tokenStart() const { return first; }
+    int tokenEnd() const { return current; }
+    ~Scanner();
+};
+
+void test_scanner(Scanner* scanner);
+
 #endif // SCANNER_H
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+
+using namespace std;
+
+static volatile sig_atomic_t detener = 0;
+
+static void alRecibirSenal(int) {
+    detener = 1;
+}
+
+static double ahora() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool leerTodo(int fd, char* p, size_t n) {
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool escribirTodo(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t r = send(fd, p, n, MSG_NOSIGNAL);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+bool leerMensaje(int fd, CabeceraMensaje& cabecera, string& datos) {
+    if (!leerTodo(fd, (char*) &cabecera, sizeof(cabecera))) return false;
+    if (cabecera.longitud > MAX_MENSAJE) return false;
+    datos.resize(cabecera.longitud);
+    return leerTodo(fd, &datos[0], cabecera.longitud);
+}
+
+bool escribirMensaje(int fd, const CabeceraMensaje& cabecera, const char* datos) {
+    return escribirTodo(fd, (const char*) &cabecera, sizeof(cabecera)) &&
+           escribirTodo(fd, datos, cabecera.longitud);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+
+void Histograma::registrar(double segundos) {
+    long us = (long) (segundos * 1e6);
+    int cubeta = 0;
+    while (cubeta < CUBETAS - 1 && (1L << (cubeta + 1)) <= us) cubeta++;
+    cubetas[cubeta]++;
+    total++;
+    long previo = maximoUs.load();
+    while (us > previo && !maximoUs.compare_exchange_weak(previo, us)) { }
+}
+
+void Histograma::imprimir(ostream& os) const {
+    long n = total.load();
+    os << "Latencias (" << n << " peticiones, máximo " << maximoUs.load() << " us):\n";
+    if (n == 0) return;
+    long acumulado = 0;
+    long p50 = -1, p90 = -1, p99 = -1;
+    for (int i = 0; i < CUBETAS; i++) {
+        long c = cubetas[i].load();
+        if (c == 0) continue;
+        acumulado += c;
+        long tope = 1L << (i + 1);
+        if (p50 < 0 && acumulado * 100 >= n * 50) p50 = tope;
+        if (p90 < 0 && acumulado * 100 >= n * 90) p90 = tope;
+        if (p99 < 0 && acumulado * 100 >= n * 99) p99 = tope;
+        os << "  " << setw(10) << (i == 0 ? 0 : 1L << i) << " - " << setw(10) << tope << " us "
+           << setw(10) << c << "  " << string((size_t) (40 * c / n), '#') << '\n';
+    }
+    os << "  p50 < " << p50 << " us, p90 < " << p90 << " us, p99 < " << p99 << " us\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+
+CompileServer::Conexion::~Conexion() {
+    close(fd);
+}
+
+CompileServer::CompileServer(const OpcionesServidor& opciones)
+    : opciones(opciones), cola(opciones.capacidadCola) { }
+
+void CompileServer::responder(Conexion& conexion, uint32_t id, uint32_t estado, string_view datos) {
+    CabeceraMensaje cabecera = {MAGIA_RESPUESTA, id, estado, (uint32_t) datos.size()};
+    lock_guard<mutex> lock(conexion.escritura);
+    escribirMensaje(conexion.fd, cabecera, datos.data());
+}
+
+void CompileServer::trabajar() {
+    // cada trabajador conserva su contexto y su buffer entre peticiones
+    CompilerContext contexto;
+    Emitter salida;
+    Trabajo t;
+    while (cola.pop(t)) {
+        if (t.flags & FLAG_ESTADISTICAS) {
+            ostringstream os;
+            latencias.imprimir(os);
+            responder(*t.conexion, t.id, ESTADO_OK, os.str());
+        } else {
+            CompileOptions op;
+            op.incremental = (t.flags & FLAG_INCREMENTAL) != 0;
+            op.optimizacion.desenrollar = (t.flags & FLAG_DESENROLLAR) >> 8;
+            op.optimizacion.vectorizar = (t.flags & FLAG_VECTORIZAR) >> 16;
+            op.memoizar = (t.flags & FLAG_MEMOIZAR) != 0;
+            if (t.flags & FLAG_ESPECIALIZAR) op.especializar = PRESUPUESTO_ESPECIALIZACION;
+            salida.clear();
+            bool ok = contexto.compile(t.fuente, op, salida);
+            if (ok && salida.flush()) {
+                responder(*t.conexion, t.id, ESTADO_OK, salida.vista());
+            } else if (ok) {
+                responder(*t.conexion, t.id, ESTADO_ERROR, "1:1: error: sin memoria para el ensamblador\n");
+            } else {
+                string diagnosticos;
+                for (auto& d : contexto.diagnosticos()) {
+                    diagnosticos += to_string(d.linea) + ":" + to_string(d.columna) + ": error: " + d.mensaje + "\n";
+                }
+                responder(*t.conexion, t.id, ESTADO_ERROR, diagnosticos);
+            }
+            latencias.registrar(ahora() - t.recibido);
+        }
+        t = Trabajo();
+    }
+}
+
+void CompileServer::atender(shared_ptr<Conexion> conexion) {
+    CabeceraMensaje cabecera;
+    string datos;
+    while (leerMensaje(conexion->fd, cabecera, datos)) {
+        if (cabecera.magia != MAGIA_PETICION) break;
+        double recibido = ahora();
+        if (!cola.push({conexion, cabecera.id, cabecera.flags, move(datos), recibido})) break;
+        datos = string();
+    }
+    lock_guard<mutex> lock(mConexiones);
+    for (size_t i = 0; i < conexionesAbiertas.size(); i++) {
+        if (conexionesAbiertas[i] == conexion->fd) {
+            conexionesAbiertas.erase(conexionesAbiertas.begin() + i);
+            break;
+        }
+    }
+    sinConexiones.notify_all();
+}
+
+int CompileServer::ejecutar() {
+    int escucha = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    if (escucha < 0 || opciones.socket.size() >= sizeof(dir.sun_path)) {
+        cerr << "No se pudo crear el socket: " << opciones.socket << endl;
+        return 1;
+    }
+    strcpy(dir.sun_path, opciones.socket.c_str());
+    unlink(opciones.socket.c_str());
+    if (bind(escucha, (sockaddr*) &dir, sizeof(dir)) < 0 || listen(escucha, 64) < 0) {
+        cerr << "No se pudo escuchar en " << opciones.socket << ": " << strerror(errno) << endl;
+        close(escucha);
+        return 1;
+    }
+    signal(SIGINT, alRecibirSenal);
+    signal(SIGTERM, alRecibirSenal);
+    signal(SIGPIPE, SIG_IGN);
+
+    vector<thread> trabajadores;
+    for (int i = 0; i < opciones.trabajadores; i++) {
+        trabajadores.emplace_back([this] { trabajar(); });
+    }
+    cerr << "Servidor escuchando en " << opciones.socket << " con "
+         << opciones.trabajadores << " trabajadores" << endl;
+
+    while (!detener) {
+        pollfd p = {escucha, POLLIN, 0};
+        if (poll(&p, 1, 200) <= 0) continue;
+        int fd = accept(escucha, nullptr, nullptr);
+        if (fd < 0) continue;
+        auto conexion = make_shared<Conexion>();
+        conexion->fd = fd;
+        {
+            lock_guard<mutex> lock(mConexiones);
+            conexionesAbiertas.push_back(fd);
+        }
+        thread([this, conexion] { atender(conexion); }).detach();
+    }
+
+    close(escucha);
+    unlink(opciones.socket.c_str());
+    {
+        // deja de leer peticiones nuevas; las pendientes se responden igual
+        unique_lock<mutex> lock(mConexiones);
+        for (int fd : conexionesAbiertas) shutdown(fd, SHUT_RD);
+        sinConexiones.wait(lock, [&] { return conexionesAbiertas.empty(); });
+    }
+    cola.cerrar();
+    for (auto& t : trabajadores) t.join();
+    latencias.imprimir(cerr);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+
+int ejecutarCliente(const string& socketPath, const vector<string>& archivos, uint32_t flags) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    if (fd < 0 || socketPath.size() >= sizeof(dir.sun_path)) {
+        cerr << "No se pudo crear el socket: " << socketPath << endl;
+        return 1;
+    }
+    strcpy(dir.sun_path, socketPath.c_str());
+    if (connect(fd, (sockaddr*) &dir, sizeof(dir)) < 0) {
+        cerr << "No se pudo conectar con el servidor " << socketPath << ": " << strerror(errno) << endl;
+        close(fd);
+        return 1;
+    }
+
+    vector<string> fuentes(archivos.size());
+    for (size_t i = 0; i < archivos.size() && !(flags & FLAG_ESTADISTICAS); i++) {
+        ifstream in(archivos[i], ios::binary);
+        if (!in.is_open()) {
+            cout << "No se pudo abrir el archivo: " << archivos[i] << endl;
+            close(fd);
+            return 1;
+        }
+        stringstream ss;
+        ss << in.rdbuf();
+        fuentes[i] = ss.str();
+    }
+
+    // las peticiones se envían desde otro hilo para no bloquearse si el
+    // servidor empieza a responder antes de recibirlo todo
+    thread envio([&] {
+        for (size_t i = 0; i < fuentes.size(); i++) {
+            CabeceraMensaje c = {MAGIA_PETICION, (uint32_t) i, flags, (uint32_t) fuentes[i].size()};
+            if (!escribirMensaje(fd, c, fuentes[i].data())) break;
+        }
+    });
+
+    int resultado = 0;
+    size_t recibidas = 0;
+    CabeceraMensaje cabecera;
+    string datos;
+    while (recibidas < archivos.size() && leerMensaje(fd, cabecera, datos)) {
+        if (cabecera.magia != MAGIA_RESPUESTA || cabecera.id >= archivos.size()) break;
+        recibidas++;
+        const string& archivo = archivos[cabecera.id];
+        if (flags & FLAG_ESTADISTICAS) {
+            cout << datos;
+            continue;
+        }
+        if (cabecera.flags != ESTADO_OK) {
+            istringstream lineas(datos);
+            string linea;
+            while (getline(lineas, linea)) cout << archivo << ":" << linea << endl;
+            resultado = 1;
+            continue;
+        }
+        size_t dotPos = archivo.find_last_of('.');
+        string baseName = (dotPos == string::npos) ? archivo : archivo.substr(0, dotPos);
+        string outputFilename = baseName + ".s";
+        cout << "Generando codigo ensamblador en " << outputFilename << endl;
+        int outfd = open(outputFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool escrito = false;
+        if (outfd >= 0) {
+            Emitter salida(outfd);
+            salida << string_view(datos);
+            escrito = salida.flush();
+            close(outfd);
+        }
+        if (!escrito) {
+            cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
+            resultado = 1;
+        }
+    }
+    if (recibidas < archivos.size()) {
+        cerr << "El servidor cerró la conexión antes de responder" << endl;
+        resultado = 1;
+    }
+    shutdown(fd, SHUT_RDWR);
+    envio.join();
+    close(fd);
+    return resultado;
+}
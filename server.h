@@ -0,0 +1,132 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "compiler.h"
+using namespace std;
+
+// Protocolo del servidor de compilación sobre un socket Unix. Cada mensaje
+// es una cabecera de 16 bytes seguida de `longitud` bytes de datos. Una
+// conexión puede enviar varias peticiones sin esperar las respuestas; cada
+// respuesta lleva el id de su petición y pueden llegar en otro orden.
+struct CabeceraMensaje {
+    uint32_t magia;
+    uint32_t id;
+    uint32_t flags;     // petición: FLAG_*; respuesta: ESTADO_*
+    uint32_t longitud;
+};
+
+const uint32_t MAGIA_PETICION = 0x5230324c;   // "L20R"
+const uint32_t MAGIA_RESPUESTA = 0x4130324c;  // "L20A"
+const uint32_t FLAG_INCREMENTAL = 1;
+const uint32_t FLAG_ESTADISTICAS = 2;         // pide el histograma de latencias
+const uint32_t FLAG_MEMOIZAR = 4;
+const uint32_t FLAG_ESPECIALIZAR = 8;         // --ipcp con PRESUPUESTO_ESPECIALIZACION
+const uint32_t FLAG_DESENROLLAR = 0xff00;     // factor de desenrollado << 8 (0: sin optimizar)
+const uint32_t FLAG_VECTORIZAR = 0xff0000;    // carriles del vectorizador << 16 (0: no vectoriza)
+const uint32_t ESTADO_OK = 0;
+const uint32_t ESTADO_ERROR = 1;              // datos: diagnósticos "linea:columna: error: ..."
+const uint32_t MAX_MENSAJE = 64u << 20;
+
+bool leerMensaje(int fd, CabeceraMensaje& cabecera, string& datos);
+bool escribirMensaje(int fd, const CabeceraMensaje& cabecera, const char* datos);
+
+// Histograma de latencias en cubetas de potencias de dos (microsegundos).
+class Histograma {
+public:
+    void registrar(double segundos);
+    void imprimir(ostream& os) const;
+private:
+    static const int CUBETAS = 40;
+    atomic<long> cubetas[CUBETAS] = {};
+    atomic<long> total{0};
+    atomic<long> maximoUs{0};
+};
+
+template <typename T>
+class ColaAcotada {
+public:
+    explicit ColaAcotada(size_t capacidad) : capacidad(capacidad) {}
+    // Bloquea mientras la cola está llena: así la presión llega hasta el
+    // socket del cliente, que deja de leerse.
+    bool push(T valor) {
+        unique_lock<mutex> lock(m);
+        hayLugar.wait(lock, [&] { return cerrada || elementos.size() < capacidad; });
+        if (cerrada) return false;
+        elementos.push_back(move(valor));
+        hayElementos.notify_one();
+        return true;
+    }
+    bool pop(T& valor) {
+        unique_lock<mutex> lock(m);
+        hayElementos.wait(lock, [&] { return cerrada || !elementos.empty(); });
+        if (elementos.empty()) return false;
+        valor = move(elementos.front());
+        elementos.pop_front();
+        hayLugar.notify_one();
+        return true;
+    }
+    void cerrar() {
+        lock_guard<mutex> lock(m);
+        cerrada = true;
+        hayLugar.notify_all();
+        hayElementos.notify_all();
+    }
+private:
+    size_t capacidad;
+    deque<T> elementos;
+    mutex m;
+    condition_variable hayLugar, hayElementos;
+    bool cerrada = false;
+};
+
+struct OpcionesServidor {
+    string socket;
+    int trabajadores = 4;
+    size_t capacidadCola = 64;
+};
+
+class CompileServer {
+public:
+    CompileServer(const OpcionesServidor& opciones);
+    // Atiende hasta recibir SIGINT o SIGTERM; al terminar imprime el
+    // histograma de latencias en stderr.
+    int ejecutar();
+private:
+    struct Conexion {
+        int fd;
+        mutex escritura;
+        ~Conexion();
+    };
+    struct Trabajo {
+        shared_ptr<Conexion> conexion;
+        uint32_t id;
+        uint32_t flags;
+        string fuente;
+        double recibido;
+    };
+    void atender(shared_ptr<Conexion> conexion);
+    void trabajar();
+    void responder(Conexion& conexion, uint32_t id, uint32_t estado, string_view datos);
+
+    OpcionesServidor opciones;
+    ColaAcotada<Trabajo> cola;
+    Histograma latencias;
+    mutex mConexiones;
+    condition_variable sinConexiones;
+    vector<int> conexionesAbiertas;
+};
+
+// Modo cliente: compila los archivos en el servidor (en paralelo, sin
+// esperar cada respuesta) y escribe <base>.s como lo haría Lab20.
+int ejecutarCliente(const string& socket, const vector<string>& archivos, uint32_t flags);
+
+#endif // SERVER_H
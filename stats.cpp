@@ -0,0 +1,279 @@
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sys/resource.h>
+#include "exp.h"
+#include "stats.h"
+
+using namespace std;
+
+static double relojPared() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double relojCpu() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Una fase que se repite (por ejemplo, una vez por función) acumula sus
+// tiempos en la misma entrada.
+void Stats::iniciarFase(const string& nombre) {
+    actual = 0;
+    while (actual < fases.size() && fases[actual].nombre != nombre) actual++;
+    if (actual == fases.size()) fases.push_back({nombre, 0, 0});
+    enFase = true;
+    inicioPared = relojPared();
+    inicioCpu = relojCpu();
+}
+
+void Stats::terminarFase() {
+    fases[actual].pared += relojPared() - inicioPared;
+    fases[actual].cpu += relojCpu() - inicioCpu;
+    enFase = false;
+}
+
+void Stats::iniciarSubfase(const string& nombre) {
+    subfase = 0;
+    while (subfase < fases.size() && fases[subfase].nombre != nombre) subfase++;
+    if (subfase == fases.size()) {
+        size_t antes = enFase ? actual : fases.size();
+        fases.insert(fases.begin() + antes, {nombre, 0, 0});
+        subfase = antes;
+        if (enFase) actual++;
+    }
+    inicioSubPared = relojPared();
+    inicioSubCpu = relojCpu();
+}
+
+void Stats::terminarSubfase() {
+    double pared = relojPared() - inicioSubPared;
+    double cpu = relojCpu() - inicioSubCpu;
+    fases[subfase].pared += pared;
+    fases[subfase].cpu += cpu;
+    if (enFase) {
+        fases[actual].pared -= pared;
+        fases[actual].cpu -= cpu;
+    }
+}
+
+void Stats::contar(const string& nombre, long n) {
+    for (auto& c : contadores) {
+        if (c.first == nombre) {
+            c.second += n;
+            return;
+        }
+    }
+    contadores.push_back({nombre, n});
+}
+
+long Stats::contador(const string& nombre) const {
+    for (auto& c : contadores) {
+        if (c.first == nombre) return c.second;
+    }
+    return 0;
+}
+
+long Stats::picoRSS() {
+    rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    return uso.ru_maxrss; // KiB en Linux
+}
+
+void Stats::imprimir(ostream& os) const {
+    double totalPared = 0, totalCpu = 0;
+    os << "Tiempos por fase:\n";
+    os << fixed << setprecision(3);
+    for (auto& f : fases) {
+        os << "  " << left << setw(12) << f.nombre << right
+           << " pared " << setw(10) << f.pared * 1000 << " ms"
+           << "   cpu " << setw(10) << f.cpu * 1000 << " ms\n";
+        totalPared += f.pared;
+        totalCpu += f.cpu;
+    }
+    os << "  " << left << setw(12) << "total" << right
+       << " pared " << setw(10) << totalPared * 1000 << " ms"
+       << "   cpu " << setw(10) << totalCpu * 1000 << " ms\n";
+    os << "Contadores:\n";
+    for (auto& c : contadores) {
+        os << "  " << left << setw(28) << c.first << right << setw(12) << c.second << '\n';
+    }
+    os << "  " << left << setw(28) << "pico_rss_kib" << right << setw(12) << picoRSS() << '\n';
+    os.unsetf(ios::floatfield);
+}
+
+void Stats::imprimirJSON(ostream& os) const {
+    os << "{\n  \"fases\": [";
+    for (size_t i = 0; i < fases.size(); i++) {
+        os << (i ? ",\n" : "\n") << "    {\"nombre\": \"" << fases[i].nombre
+           << "\", \"pared_s\": " << setprecision(9) << fases[i].pared
+           << ", \"cpu_s\": " << fases[i].cpu << "}";
+    }
+    os << "\n  ],\n  \"contadores\": {";
+    for (size_t i = 0; i < contadores.size(); i++) {
+        os << (i ? ",\n" : "\n") << "    \"" << contadores[i].first << "\": " << contadores[i].second;
+    }
+    os << (contadores.empty() ? "" : ",") << "\n    \"pico_rss_kib\": " << picoRSS() << "\n  }\n}\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+
+void NodeCounter::contar(const char* tipo) {
+    for (auto& n : nodos) {
+        if (n.first == tipo) {
+            n.second++;
+            return;
+        }
+    }
+    nodos.push_back({tipo, 1});
+}
+
+void NodeCounter::visit(Program* p) {
+    contar("Program");
+    p->vardecs->accept(this);
+    p->fundecs->accept(this);
+    terminar();
+}
+
+void NodeCounter::terminar() {
+    long total = 0;
+    for (auto& n : nodos) {
+        stats.contar(string("nodos.") + n.first, n.second);
+        total += n.second;
+    }
+    stats.contar("nodos.total", total);
+    nodos.clear();
+}
+
+// Las expresiones se recorren con una pila explícita (preorden, como la
+// versión recursiva) para soportar cadenas muy largas.
+void NodeCounter::contarExp(Exp* raiz) {
+    vector<Exp*> pila = {raiz};
+    while (!pila.empty()) {
+        Exp* e = pila.back();
+        pila.pop_back();
+        if (e->kind == BINARY_EXP) {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            contar("BinaryExp");
+            pila.push_back(b->right);
+            pila.push_back(b->left);
+        } else if (e->kind == FCALL_EXP) {
+            FCallExp* f = static_cast<FCallExp*>(e);
+            contar("FCallExp");
+            pila.insert(pila.end(), f->argumentos.rbegin(), f->argumentos.rend());
+        } else if (e->kind == INDEX_EXP) {
+            contar("IndexExp");
+            pila.push_back(static_cast<IndexExp*>(e)->indice);
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            contar("IfExp");
+            pila.push_back(x->sino);
+            pila.push_back(x->entonces);
+            pila.push_back(x->condicion);
+        } else {
+            e->accept(this);
+        }
+    }
+}
+
+int NodeCounter::visit(BinaryExp* exp) {
+    contarExp(exp);
+    return 0;
+}
+
+int NodeCounter::visit(NumberExp*) {
+    contar("NumberExp");
+    return 0;
+}
+
+int NodeCounter::visit(BoolExp*) {
+    contar("BoolExp");
+    return 0;
+}
+
+int NodeCounter::visit(IdentifierExp*) {
+    contar("IdentifierExp");
+    return 0;
+}
+
+int NodeCounter::visit(FCallExp* exp) {
+    contarExp(exp);
+    return 0;
+}
+
+int NodeCounter::visit(IndexExp* exp) {
+    contarExp(exp);
+    return 0;
+}
+
+int NodeCounter::visit(IfExp* exp) {
+    contarExp(exp);
+    return 0;
+}
+
+void NodeCounter::visit(ReturnStatement* stm) {
+    contar("ReturnStatement");
+    if (stm->e) stm->e->accept(this);
+}
+
+void NodeCounter::visit(FunDec* f) {
+    contar("FunDec");
+    f->cuerpo->accept(this);
+}
+
+void NodeCounter::visit(FunDecList* f) {
+    contar("FunDecList");
+    for (auto dec : f->Fundecs) dec->accept(this);
+}
+
+void NodeCounter::visit(AssignStatement* stm) {
+    contar("AssignStatement");
+    if (stm->indice) stm->indice->accept(this);
+    stm->rhs->accept(this);
+}
+
+void NodeCounter::visit(PrintStatement* stm) {
+    contar("PrintStatement");
+    stm->e->accept(this);
+}
+
+void NodeCounter::visit(IfStatement* stm) {
+    contar("IfStatement");
+    stm->condition->accept(this);
+    stm->then->accept(this);
+    if (stm->els) stm->els->accept(this);
+}
+
+void NodeCounter::visit(WhileStatement* stm) {
+    contar("WhileStatement");
+    stm->condition->accept(this);
+    stm->b->accept(this);
+}
+
+void NodeCounter::visit(ForStatement* stm) {
+    contar("ForStatement");
+    stm->inicio->accept(this);
+    stm->fin->accept(this);
+    stm->b->accept(this);
+}
+
+void NodeCounter::visit(VarDec*) {
+    contar("VarDec");
+}
+
+void NodeCounter::visit(VarDecList* stm) {
+    contar("VarDecList");
+    for (auto dec : stm->vardecs) dec->accept(this);
+}
+
+void NodeCounter::visit(StatementList* stm) {
+    contar("StatementList");
+    for (auto s : stm->stms) s->accept(this);
+}
+
+void NodeCounter::visit(Body* b) {
+    contar("Body");
+    b->vardecs->accept(this);
+    b->slist->accept(this);
+}
@@ -0,0 +1,75 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "visitor.h"
+using namespace std;
+
+// Tiempos por fase (pared y CPU) y contadores de la compilación, al estilo
+// de -ftime-report. Se imprimen en texto o en JSON.
+class Stats {
+public:
+    void iniciarFase(const string& nombre);
+    void terminarFase();
+    // Una fase medida a trozos dentro de otra (el scanner, al que el parser
+    // le pide tokens a demanda): su tiempo se descuenta de la que la
+    // contiene, y se lista antes que ella.
+    void iniciarSubfase(const string& nombre);
+    void terminarSubfase();
+    void contar(const string& nombre, long n = 1);
+    long contador(const string& nombre) const;
+    void imprimir(ostream& os) const;
+    void imprimirJSON(ostream& os) const;
+    static long picoRSS();
+private:
+    struct Fase {
+        string nombre;
+        double pared;
+        double cpu;
+    };
+    vector<Fase> fases;
+    vector<pair<string, long>> contadores;
+    size_t actual = 0;
+    bool enFase = false;
+    double inicioPared = 0, inicioCpu = 0;
+    size_t subfase = 0;
+    double inicioSubPared = 0, inicioSubCpu = 0;
+};
+
+// Cuenta los nodos del AST por tipo. visit(Program) vuelca los conteos en
+// stats; si se visitan partes sueltas hay que llamar a terminar().
+class NodeCounter : public Visitor {
+public:
+    NodeCounter(Stats& stats) : stats(stats) {}
+    void terminar();
+    void visit(Program* p) override;
+    int visit(BinaryExp* exp) override;
+    int visit(NumberExp* exp) override;
+    int visit(BoolExp* exp) override;
+    int visit(IdentifierExp* exp) override;
+    int visit(FCallExp* exp) override;
+    int visit(IndexExp* exp) override;
+    int visit(IfExp* exp) override;
+    void visit(ReturnStatement* stm) override;
+    void visit(FunDec* f) override;
+    void visit(FunDecList* f) override;
+    void visit(AssignStatement* stm) override;
+    void visit(PrintStatement* stm) override;
+    void visit(IfStatement* stm) override;
+    void visit(WhileStatement* stm) override;
+    void visit(ForStatement* stm) override;
+    void visit(VarDec* stm) override;
+    void visit(VarDecList* stm) override;
+    void visit(StatementList* stm) override;
+    void visit(Body* b) override;
+private:
+    void contar(const char* tipo);
+    void contarExp(Exp* raiz);
+    Stats& stats;
+    vector<pair<const char*, long>> nodos;
+};
+
+#endif // STATS_H
@@ -0,0 +1,16 @@
+#include <unistd.h>
+#include "trace.h"
+
+std::atomic<int> Traza::nivel{TRAZA_NADA};
+thread_local Emitter* Traza::destino = nullptr;
+
+Emitter& Traza::sink() {
+    if (destino != nullptr) return *destino;
+    // un buffer por hilo hacia stderr; se vacía al terminar el hilo
+    static thread_local Emitter porDefecto(STDERR_FILENO, 1 << 16);
+    return porDefecto;
+}
+
+void Traza::redirigir(Emitter* d) {
+    destino = d;
+}
@@ -0,0 +1,31 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include "emitter.h"
+
+// Niveles de traza. LAB20_TRAZA_MAX fija en compilación el nivel más alto
+// que llega a existir en el binario; Traza::nivel elige en ejecución cuál
+// se imprime (por defecto ninguno) y vale para todos los hilos, también
+// los del servidor; cada hilo escribe en su propio destino. Con la traza
+// apagada, TRAZA no evalúa sus argumentos.
+enum NivelTraza { TRAZA_NADA = 0, TRAZA_ERROR = 1, TRAZA_INFO = 2, TRAZA_DEBUG = 3 };
+
+#ifndef LAB20_TRAZA_MAX
+#define LAB20_TRAZA_MAX TRAZA_DEBUG
+#endif
+
+class Traza {
+public:
+    static bool activa(int n) { return n <= LAB20_TRAZA_MAX && n <= nivel.load(std::memory_order_relaxed); }
+    static Emitter& sink();
+    static void redirigir(Emitter* destino);
+    static std::atomic<int> nivel;
+private:
+    static thread_local Emitter* destino;
+};
+
+#define TRAZA(n, mensaje) \
+    do { if (Traza::activa(n)) { Traza::sink() << mensaje << '\n'; } } while (0)
+
+#endif // TRACE_H
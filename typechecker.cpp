@@ -0,0 +1,343 @@
+#include <algorithm>
+#include "typechecker.h"
+
+using namespace std;
+
+// La sentencia en curso si el parser la ubicó; si no, la función.
+void TypeChecker::posicion(int& linea, int& columna) const {
+    linea = columna = 0;
+    if (sentencia && sentencia->linea > 0) {
+        linea = sentencia->linea;
+        columna = sentencia->columna;
+    } else if (actual) {
+        linea = actual->linea;
+        columna = actual->columna;
+    }
+}
+
+void TypeChecker::error(const string& mensaje) {
+    int linea, columna;
+    posicion(linea, columna);
+    error(linea, columna, actual ? "en '" + actual->nombre + "': " + mensaje : mensaje);
+}
+
+void TypeChecker::error(int linea, int columna, const string& mensaje) {
+    diagnosticos.push_back({linea, columna, mensaje});
+}
+
+void TypeChecker::declararVariables(VarDecList* vardecs, unordered_map<string, Tipo>& destino) {
+    for (auto dec : vardecs->vardecs) {
+        Tipo tipo = tipoDeNombre(dec->type);
+        if (tipo == TIPO_DESCONOCIDO) {
+            error(dec->linea, dec->columna, "tipo desconocido '" + dec->type + "'");
+        }
+        if (dec->longitud > 0) {
+            if (tipo == TIPO_BOOL) error(dec->linea, dec->columna, "solo hay arreglos de int");
+            tipo = TIPO_ARREGLO;
+        }
+        for (auto& v : dec->vars) {
+            if (!destino.emplace(v, tipo).second) {
+                error(dec->linea, dec->columna, "la variable '" + v + "' ya está declarada");
+            }
+        }
+    }
+}
+
+void TypeChecker::declararGlobales(VarDecList* vardecs) {
+    declararVariables(vardecs, globales);
+}
+
+void TypeChecker::declararFuncion(const string& nombre, const string& retorno, const vector<string>& parametros,
+                                  int linea, int columna) {
+    Firma firma;
+    firma.retorno = tipoDeNombre(retorno);
+    if (firma.retorno == TIPO_DESCONOCIDO) {
+        error(linea, columna, "tipo de retorno desconocido '" + retorno + "' en '" + nombre + "'");
+    }
+    for (auto& p : parametros) {
+        Tipo tipo = tipoDeNombre(p);
+        if (tipo == TIPO_DESCONOCIDO) {
+            error(linea, columna, "tipo desconocido '" + p + "' en los parámetros de '" + nombre + "'");
+        }
+        firma.parametros.push_back(tipo);
+    }
+    if (!funciones.emplace(nombre, firma).second) {
+        error(linea, columna, "la función '" + nombre + "' ya está declarada");
+    }
+}
+
+void TypeChecker::declararFuncion(FunDec* f) {
+    declararFuncion(f->nombre, f->tipo, vector<string>(f->tipos.begin(), f->tipos.end()), f->linea, f->columna);
+}
+
+void TypeChecker::declararFuncion(const Cabecera& c) {
+    declararFuncion(c.nombre, c.retorno, c.parametros, c.linea, c.columna);
+}
+
+bool TypeChecker::verificar(FunDec* f) {
+    size_t antes = diagnosticos.size();
+    actual = f;
+    locales.clear();
+    auto tipoParametro = f->tipos.begin();
+    for (auto& p : f->parametros) {
+        Tipo tipo = tipoParametro != f->tipos.end() ? tipoDeNombre(*tipoParametro++) : TIPO_DESCONOCIDO;
+        if (!locales.emplace(p, tipo).second) error("el parámetro '" + p + "' está repetido");
+    }
+    verificarBloque(f->cuerpo);
+    actual = nullptr;
+    sentencia = nullptr;
+    return diagnosticos.size() == antes;
+}
+
+// Los bloques anidados comparten el espacio de nombres de la función,
+// igual que en GenCodeVisitor.
+void TypeChecker::verificarBloque(Body* b) {
+    declararVariables(b->vardecs, locales);
+    Tipo retorno = funciones.count(actual->nombre) ? funciones[actual->nombre].retorno : TIPO_DESCONOCIDO;
+    for (auto s : b->slist->stms) {
+        sentencia = s;
+        switch (s->kind) {
+            case ASSIGN_STM: {
+                AssignStatement* a = static_cast<AssignStatement*>(s);
+                Tipo variable = tipoDeVariable(a->id);
+                if (!a->indice && count(variablesFor.begin(), variablesFor.end(), a->id)) {
+                    error("la variable '" + a->id + "' del for no se asigna dentro del for");
+                }
+                if (a->indice) {
+                    variable = tipoDeElemento(a->id, variable, tipoDe(a->indice));
+                } else if (variable == TIPO_ARREGLO) {
+                    error("no se puede asignar el arreglo '" + a->id + "' entero; falta el índice");
+                    variable = TIPO_DESCONOCIDO;
+                }
+                Tipo valor = tipoDe(a->rhs);
+                if (variable != TIPO_DESCONOCIDO && valor != TIPO_DESCONOCIDO && variable != valor) {
+                    error(string("no se puede asignar un ") + nombreDeTipo(valor) + " a '" + a->id
+                          + "', que es " + nombreDeTipo(variable));
+                }
+                break;
+            }
+            case PRINT_STM:
+                tipoDe(static_cast<PrintStatement*>(s)->e);
+                break;
+            case RETURN_STM: {
+                Exp* e = static_cast<ReturnStatement*>(s)->e;
+                if (e == nullptr) {
+                    error("return sin valor");
+                    break;
+                }
+                Tipo valor = tipoDe(e);
+                if (retorno != TIPO_DESCONOCIDO && valor != TIPO_DESCONOCIDO && valor != retorno) {
+                    error(string("return de un ") + nombreDeTipo(valor) + " en una función que devuelve "
+                          + nombreDeTipo(retorno));
+                }
+                break;
+            }
+            case IF_STM: {
+                IfStatement* i = static_cast<IfStatement*>(s);
+                Tipo condicion = tipoDe(i->condition);
+                if (condicion != TIPO_DESCONOCIDO && condicion != TIPO_BOOL) {
+                    error(string("la condición del if debe ser bool, no ") + nombreDeTipo(condicion));
+                }
+                verificarBloque(i->then);
+                if (i->els) verificarBloque(i->els);
+                break;
+            }
+            case WHILE_STM: {
+                WhileStatement* w = static_cast<WhileStatement*>(s);
+                Tipo condicion = tipoDe(w->condition);
+                if (condicion != TIPO_DESCONOCIDO && condicion != TIPO_BOOL) {
+                    error(string("la condición del while debe ser bool, no ") + nombreDeTipo(condicion));
+                }
+                verificarBloque(w->b);
+                break;
+            }
+            case FOR_STM: {
+                ForStatement* f = static_cast<ForStatement*>(s);
+                Tipo variable = tipoDeVariable(f->variable);
+                if (variable != TIPO_DESCONOCIDO && variable != TIPO_INT) {
+                    error("la variable '" + f->variable + "' del for debe ser int, no " + nombreDeTipo(variable));
+                } else if (count(variablesFor.begin(), variablesFor.end(), f->variable)) {
+                    error("la variable '" + f->variable + "' del for no se asigna dentro del for");
+                }
+                Tipo inicio = tipoDe(f->inicio);
+                Tipo fin = tipoDe(f->fin);
+                for (Tipo limite : {inicio, fin}) {
+                    if (limite != TIPO_DESCONOCIDO && limite != TIPO_INT) {
+                        error(string("los límites del for deben ser int, no ") + nombreDeTipo(limite));
+                    }
+                }
+                variablesFor.push_back(f->variable);
+                verificarBloque(f->b);
+                variablesFor.pop_back();
+                break;
+            }
+        }
+    }
+}
+
+Tipo TypeChecker::tipoDeVariable(const string& nombre) {
+    // GenCodeVisitor resuelve primero las globales
+    auto g = globales.find(nombre);
+    if (g != globales.end()) return g->second;
+    auto l = locales.find(nombre);
+    if (l != locales.end()) return l->second;
+    error("la variable '" + nombre + "' no está declarada");
+    // se registra para no repetir el mismo error en cada uso
+    locales[nombre] = TIPO_DESCONOCIDO;
+    return TIPO_DESCONOCIDO;
+}
+
+// Resuelve los tipos de las hojas hacia la raíz con una pila explícita.
+// Una subexpresión con errores queda TIPO_DESCONOCIDO y no produce más
+// errores hacia arriba.
+Tipo TypeChecker::tipoDe(Exp* raiz) {
+    struct Marco {
+        Exp* e;
+        bool hijos;
+    };
+    vector<Marco> pila = {{raiz, false}};
+    vector<Tipo> argumentos;
+    while (!pila.empty()) {
+        Marco& m = pila.back();
+        Exp* e = m.e;
+        if (!m.hijos && !e->esHoja()) {
+            m.hijos = true;
+            if (e->kind == BINARY_EXP) {
+                BinaryExp* b = static_cast<BinaryExp*>(e);
+                pila.push_back({b->left, false});
+                pila.push_back({b->right, false});
+            } else if (e->kind == INDEX_EXP) {
+                pila.push_back({static_cast<IndexExp*>(e)->indice, false});
+            } else if (e->kind == IF_EXP) {
+                IfExp* x = static_cast<IfExp*>(e);
+                pila.push_back({x->condicion, false});
+                pila.push_back({x->entonces, false});
+                pila.push_back({x->sino, false});
+            } else {
+                for (auto arg : static_cast<FCallExp*>(e)->argumentos) pila.push_back({arg, false});
+            }
+            continue;
+        }
+        pila.pop_back();
+        switch (e->kind) {
+            case NUMBER_EXP:
+                e->tipo = TIPO_INT; break;
+            case BOOL_EXP:
+                e->tipo = TIPO_BOOL; break;
+            case IDENTIFIER_EXP: {
+                const string& nombre = static_cast<IdentifierExp*>(e)->name;
+                e->tipo = tipoDeVariable(nombre);
+                if (e->tipo == TIPO_ARREGLO) {
+                    error("el arreglo '" + nombre + "' solo se usa con un índice");
+                    e->tipo = TIPO_DESCONOCIDO;
+                }
+                break;
+            }
+            case INDEX_EXP: {
+                IndexExp* x = static_cast<IndexExp*>(e);
+                tipoDeElemento(x->nombre, tipoDeVariable(x->nombre), x->indice->tipo);
+                e->tipo = TIPO_INT;
+                break;
+            }
+            case BINARY_EXP: {
+                BinaryExp* b = static_cast<BinaryExp*>(e);
+                Tipo l = b->left->tipo, r = b->right->tipo;
+                bool comparacion = b->op == LT_OP || b->op == LE_OP || b->op == EQ_OP;
+                e->tipo = comparacion ? TIPO_BOOL : TIPO_INT;
+                if (l == TIPO_DESCONOCIDO || r == TIPO_DESCONOCIDO) break;
+                if (b->op == EQ_OP) {
+                    if (l != r) {
+                        error(string("no se puede comparar un ") + nombreDeTipo(l) + " con un " + nombreDeTipo(r));
+                    }
+                } else if (l != TIPO_INT || r != TIPO_INT) {
+                    error("los operandos de '" + Exp::binopToChar(b->op) + "' deben ser int, no "
+                          + nombreDeTipo(l != TIPO_INT ? l : r));
+                }
+                break;
+            }
+            case IF_EXP: {
+                IfExp* x = static_cast<IfExp*>(e);
+                Tipo c = x->condicion->tipo, a = x->entonces->tipo, b = x->sino->tipo;
+                if (c != TIPO_DESCONOCIDO && c != TIPO_BOOL) {
+                    error(string("la condición de ifexp debe ser bool, no ") + nombreDeTipo(c));
+                }
+                e->tipo = a == TIPO_DESCONOCIDO ? b : a;
+                if (a != TIPO_DESCONOCIDO && b != TIPO_DESCONOCIDO && a != b) {
+                    error(string("las ramas de ifexp deben tener el mismo tipo: ") + nombreDeTipo(a) + " y "
+                          + nombreDeTipo(b));
+                    e->tipo = TIPO_DESCONOCIDO;
+                }
+                break;
+            }
+            case FCALL_EXP: {
+                FCallExp* f = static_cast<FCallExp*>(e);
+                argumentos.clear();
+                for (auto arg : f->argumentos) argumentos.push_back(arg->tipo);
+                auto firma = funciones.find(f->nombre);
+                if (firma == funciones.end()) {
+                    // se declara más adelante; mientras tanto se supone int
+                    int linea, columna;
+                    posicion(linea, columna);
+                    pendientes.push_back({f->nombre, argumentos, linea, columna, actual->nombre});
+                    e->tipo = TIPO_INT;
+                } else {
+                    verificarLlamada(f->nombre, firma->second, argumentos);
+                    e->tipo = firma->second.retorno;
+                }
+                break;
+            }
+        }
+    }
+    return raiz->tipo;
+}
+
+// a[i]: a tiene que ser un arreglo e i un int. Devuelve el tipo del
+// elemento, o TIPO_DESCONOCIDO si a no es un arreglo.
+Tipo TypeChecker::tipoDeElemento(const string& nombre, Tipo variable, Tipo indice) {
+    if (variable != TIPO_ARREGLO) {
+        if (variable != TIPO_DESCONOCIDO) error("'" + nombre + "' no es un arreglo");
+        return TIPO_DESCONOCIDO;
+    }
+    if (indice != TIPO_DESCONOCIDO && indice != TIPO_INT) {
+        error("el índice de '" + nombre + "' debe ser int, no " + nombreDeTipo(indice));
+    }
+    return TIPO_INT;
+}
+
+void TypeChecker::verificarLlamada(const string& nombre, const Firma& firma, const vector<Tipo>& argumentos) {
+    if (argumentos.size() != firma.parametros.size()) {
+        error("'" + nombre + "' recibe " + to_string(firma.parametros.size()) + " argumentos, no "
+              + to_string(argumentos.size()));
+        return;
+    }
+    for (size_t i = 0; i < argumentos.size(); i++) {
+        Tipo esperado = firma.parametros[i], dado = argumentos[i];
+        if (esperado != TIPO_DESCONOCIDO && dado != TIPO_DESCONOCIDO && esperado != dado) {
+            error("el argumento " + to_string(i + 1) + " de '" + nombre + "' debe ser "
+                  + nombreDeTipo(esperado) + ", no " + nombreDeTipo(dado));
+        }
+    }
+}
+
+void TypeChecker::terminar(bool exigirDeclaradas) {
+    for (auto& p : pendientes) {
+        auto firma = funciones.find(p.nombre);
+        // los errores se ubican en la función que hace la llamada
+        size_t antes = diagnosticos.size();
+        if (firma == funciones.end()) {
+            if (exigirDeclaradas) error(p.linea, p.columna, "en '" + p.funcion + "': la función '" + p.nombre + "' no está declarada");
+            continue;
+        }
+        verificarLlamada(p.nombre, firma->second, p.argumentos);
+        if (firma->second.retorno != TIPO_INT) {
+            error("'" + p.nombre + "' se usa como int antes de su declaración, pero devuelve "
+                  + nombreDeTipo(firma->second.retorno));
+        }
+        for (size_t i = antes; i < diagnosticos.size(); i++) {
+            diagnosticos[i].linea = p.linea;
+            diagnosticos[i].columna = p.columna;
+            diagnosticos[i].mensaje = "en '" + p.funcion + "': " + diagnosticos[i].mensaje;
+        }
+    }
+    pendientes.clear();
+}
@@ -0,0 +1,71 @@
+#ifndef TYPECHECKER_H
+#define TYPECHECKER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "exp.h"
+#include "parser.h"
+using namespace std;
+
+// Análisis semántico: resuelve el tipo de cada variable, función y
+// expresión, lo deja en Exp::tipo y rechaza los programas mal tipados
+// antes de generar código. Reglas:
+//  - + - * / operan int; < <= comparan int; == compara dos int o dos bool
+//  - las condiciones de if y while son bool
+//  - asignaciones, argumentos y return respetan el tipo declarado
+//  - un arreglo (var int[N] a) solo se usa como a[i], con i int
+//  - la variable y los límites de un for son int y el cuerpo no asigna la
+//    variable
+//  - la condición de ifexp(c, a, b) es bool y a y b tienen el mismo tipo
+// Se usa función por función: las firmas se declaran antes de verificar los
+// cuerpos (leerCabeceras); si alguna falta, una llamada a una función que
+// todavía no se vio queda pendiente hasta terminar().
+class TypeChecker {
+public:
+    void declararGlobales(VarDecList* globales);
+    void declararFuncion(const string& nombre, const string& retorno, const vector<string>& parametros,
+                         int linea, int columna);
+    void declararFuncion(FunDec* f);
+    void declararFuncion(const Cabecera& c);
+    // anota los tipos de f; devuelve false si encontró errores en ella
+    bool verificar(FunDec* f);
+    // comprueba las llamadas pendientes contra las funciones declaradas;
+    // con exigirDeclaradas = false se ignoran las que siguen sin declarar
+    void terminar(bool exigirDeclaradas = true);
+    bool hayErrores() const { return !diagnosticos.empty(); }
+    const vector<Diagnostico>& errores() const { return diagnosticos; }
+private:
+    struct Firma {
+        Tipo retorno;
+        vector<Tipo> parametros;
+    };
+    struct Pendiente {
+        string nombre;
+        vector<Tipo> argumentos;
+        int linea, columna;
+        string funcion;
+    };
+    void posicion(int& linea, int& columna) const;
+    void error(const string& mensaje);
+    void error(int linea, int columna, const string& mensaje);
+    void declararVariables(VarDecList* vardecs, unordered_map<string, Tipo>& destino);
+    void verificarBloque(Body* b);
+    Tipo tipoDe(Exp* raiz);
+    Tipo tipoDeVariable(const string& nombre);
+    Tipo tipoDeElemento(const string& nombre, Tipo variable, Tipo indice);
+    void verificarLlamada(const string& nombre, const Firma& firma, const vector<Tipo>& argumentos);
+
+    unordered_map<string, Tipo> globales;
+    unordered_map<string, Firma> funciones;
+    unordered_map<string, Tipo> locales;
+    // variables de los for que encierran la sentencia en curso
+    vector<string> variablesFor;
+    vector<Pendiente> pendientes;
+    vector<Diagnostico> diagnosticos;
+    // función y sentencia en curso, para ubicar los errores
+    FunDec* actual = nullptr;
+    Stm* sentencia = nullptr;
+};
+
+#endif // TYPECHECKER_H
@@ -1,325 +1,1543 @@
-#include <iostream>
-#include "exp.h"
-#include "visitor.h"
-#include <unordered_map>
-using namespace std;
-
-///////////////////////////////////////////////////////////////////////////////////
-int BinaryExp::accept(Visitor *visitor)
-{
-    return visitor->visit(this);
-}
-
-int NumberExp::accept(Visitor *visitor)
-{
-    return visitor->visit(this);
-}
-
-int BoolExp::accept(Visitor *visitor)
-{
-    return visitor->visit(this);
-}
-
-int IdentifierExp::accept(Visitor *visitor)
-{
-    return visitor->visit(this);
-}
-
-int AssignStatement::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int PrintStatement::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int IfStatement::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int WhileStatement::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-
-int VarDec::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int VarDecList::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-int StatementList::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int Body::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-int FCallExp::accept(Visitor *visitor)
-{
-    return visitor->visit(this);
-}
-int ReturnStatement::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int FunDec::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-int FunDecList::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-
-int Program::accept(Visitor *visitor)
-{
-    visitor->visit(this);
-    return 0;
-}
-///////////////////////////////////////////////////////////////////////////////////
-
-void GenCodeVisitor::generar(Program* program) {
-    program->accept(this);
-}
-
-void GenCodeVisitor::visit(Program* program) {
-out << ".data\nprint_fmt: .string \"%ld \\n\""<<endl;
-    program->vardecs->accept(this);
-
-    for (auto& [var, _] : memoriaGlobal) {
-        out << var << ": .quad 0"<<endl;
-    }
-
-    out << ".text\n";
-    program->fundecs->accept(this);
-    out << ".section .note.GNU-stack,\"\",@progbits"<<endl;
-}
-
-void GenCodeVisitor::visit(VarDec* stm) {
-    for (auto var : stm->vars) {
-        if (!entornoFuncion) {
-            memoriaGlobal[var] = true;
-        } else {
-            memoria[var] = offset;
-            offset -= 8;
-        }
-    }
-}
-
-void GenCodeVisitor::visit(VarDecList* stm) {
-    for (auto dec : stm->vardecs)
-        dec->accept(this);
-}
-
-int GenCodeVisitor::visit(NumberExp* exp) {
-    out << " movq $" << exp->value << ", %rax"<<endl;
-    return 0;
-}
-
-int GenCodeVisitor::visit(IdentifierExp* exp) {
-    if (memoriaGlobal.count(exp->name))
-        out << " movq " << exp->name << "(%rip), %rax"<<endl;
-    else
-        out << " movq " << memoria[exp->name] << "(%rbp), %rax"<<endl;
-    return 0;
-}
-
-int GenCodeVisitor::visit(BinaryExp* exp) {
-    int l = exp->left->etiqueta;
-    int r = exp->right->etiqueta;
-
-    if (exp->op == PLUS_OP || exp->op == MUL_OP) {
-        if (r == 0) {
-            exp->left->accept(this);          
-            out << " movq %rax, %rcx\n";       
-            exp->right->accept(this);           
-        }
-        else if (l > r) {
-            exp->left->accept(this);           
-            out << " pushq %rax\n";            
-            exp->right->accept(this);          
-            out << " movq %rax, %rcx\n";
-            out << " popq %rax\n";
-        }
-        else if (r > l) {
-            exp->right->accept(this);          
-            out << " pushq %rax\n";
-            exp->left->accept(this);           
-            out << " movq %rax, %rcx\n";
-            out << " popq %rax\n";
-            out << " xchgq %rax, %rcx\n";       
-        }
-        else { // l == r
-            exp->left->accept(this);           
-            out << " pushq %rax\n";
-            exp->right->accept(this);          
-            out << " movq %rax, %rcx\n";
-            out << " popq %rax\n";
-        }
-
-        if (exp->op == PLUS_OP)
-            out << " addq %rcx, %rax\n";
-        else // MUL_OP
-            out << " imulq %rcx, %rax\n";
-    }
-
-
-    else {
-        exp->left->accept(this);              
-        out << " pushq %rax\n";
-        exp->right->accept(this);              
-        out << " movq %rax, %rcx\n";
-        out << " popq %rax\n";                 
-
-        switch (exp->op) {
-            case MINUS_OP:
-                out << " subq %rcx, %rax\n"; break;
-
-            case LE_OP:
-                out << " cmpq %rcx, %rax\n"
-                    << " movl $0, %eax\n"
-                    << " setle %al\n"
-                    << " movzbq %al, %rax\n"; break;
-
-            case LT_OP:
-                out << " cmpq %rcx, %rax\n"
-                    << " movl $0, %eax\n"
-                    << " setl %al\n"
-                    << " movzbq %al, %rax\n"; break;
-
-        }
-    }
-
-    return 0;
-}
-
-void GenCodeVisitor::visit(AssignStatement* stm) {
-    stm->rhs->accept(this);
-    if (memoriaGlobal.count(stm->id))
-        out << " movq %rax, " << stm->id << "(%rip)"<<endl;
-    else
-        out << " movq %rax, " << memoria[stm->id] << "(%rbp)"<<endl;
-}
-
-void GenCodeVisitor::visit(PrintStatement* stm) {
-    stm->e->accept(this);
-    out <<
-        " movq %rax, %rsi\n"
-        " leaq print_fmt(%rip), %rdi\n"
-        " movl $0, %eax\n"
-        " call printf@PLT\n";
-}
-
-
-
-
-
-
-
-void GenCodeVisitor::visit(FunDecList* f) {
-    for (auto dec : f->Fundecs)
-        dec->accept(this);
-}
-
-void GenCodeVisitor::visit(StatementList* stm) {
-    for (auto s : stm->stms)
-        s->accept(this);
-}
-
-void GenCodeVisitor::visit(Body* b) {
-    b->vardecs->accept(this);
-    b->slist->accept(this);
-}
-
-void GenCodeVisitor::visit(IfStatement* stm) {
-    int label = labelcont++;
-    stm->condition->accept(this);
-    out << " cmpq $0, %rax"<<endl;
-    out << " je else_" << label << endl;
-    stm->then->accept(this);
-    out << " jmp endif_" << label << endl;
-    out << " else_" << label << ":"<< endl;
-    if (stm->els) stm->els->accept(this);
-    out << "endif_" << label << ":"<< endl;
-}
-
-void GenCodeVisitor::visit(WhileStatement* stm) {
-    int label = labelcont++;
-    out << "while_" << label << ":"<<endl;
-    stm->condition->accept(this);
-    out << " cmpq $0, %rax" << endl;
-    out << " je endwhile_" << label << endl;
-    stm->b->accept(this);
-    out << " jmp while_" << label << endl;
-    out << "endwhile_" << label << ":"<< endl;
-}
-
-int GenCodeVisitor::visit(BoolExp* exp) {
-    out << " movq $" << exp->value << ", %rax"<< endl;
-    return 0;
-}
-
-void GenCodeVisitor::visit(ReturnStatement* stm) {
-    stm->e->accept(this);
-    out << " jmp .end_"<<nombreFuncion << endl;
-}
-
-void GenCodeVisitor::visit(FunDec* f) {
-    entornoFuncion = true;
-    memoria.clear();
-    offset = -8;
-    nombreFuncion = f->nombre;
-    vector<std::string> argRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
-    out << ".globl " << f->nombre << endl;
-    out << f->nombre <<  ":" << endl;
-    out << " pushq %rbp" << endl;
-    out << " movq %rsp, %rbp" << endl;
-    int size = f->parametros.size();
-    for (int i = 0; i < size; i++) {
-        memoria[f->parametros[i]]=offset;
-        out << " movq " << argRegs[i] << "," << offset << "(%rbp)" << endl;
-        offset -= 8;
-    }
-    f->cuerpo->vardecs->accept(this);
-    int reserva = -offset - 8;
-    out << " subq $" << reserva << ", %rsp" << endl;
-    f->cuerpo->slist->accept(this);
-    out << ".end_"<< f->nombre << ":"<< endl;
-    out << "leave" << endl;
-    out << "ret" << endl;
-    entornoFuncion = false;
-}
-
-int GenCodeVisitor::visit(FCallExp* exp) {
-    vector<std::string> argRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
-    int size = exp->argumentos.size();
-    for (int i = 0; i < size; i++) {
-        exp->argumentos[i]->accept(this);
-        out << " movq %rax, " << argRegs[i] <<endl;
-    }
-    out << "call " << exp->nombre << endl;
-    return 0;
-}
-
+#include <algorithm>
+#include <iostream>
+#include "exp.h"
+#include "visitor.h"
+#include "trace.h"
+#include <unordered_map>
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////////
+int BinaryExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+
+int NumberExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+
+int BoolExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+
+int IdentifierExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+
+int IndexExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+
+int IfExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+
+int AssignStatement::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int PrintStatement::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int IfStatement::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int WhileStatement::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int ForStatement::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+
+int VarDec::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int VarDecList::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+int StatementList::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int Body::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+int FCallExp::accept(Visitor *visitor)
+{
+    return visitor->visit(this);
+}
+int ReturnStatement::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int FunDec::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+int FunDecList::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+
+int Program::accept(Visitor *visitor)
+{
+    visitor->visit(this);
+    return 0;
+}
+///////////////////////////////////////////////////////////////////////////////////
+
+void GenCodeVisitor::generar(Program* program) {
+    program->accept(this);
+}
+
+void GenCodeVisitor::visit(Program* program) {
+    generarCabecera(program->vardecs);
+    program->fundecs->accept(this);
+    generarPie();
+}
+
+// Escapa una cadena para una directiva .string/.file.
+static string entreComillas(const string& texto) {
+    string r = "\"";
+    for (char c : texto) {
+        if (c == '"' || c == '\\') r += '\\';
+        r += c;
+    }
+    return r + '"';
+}
+
+void GenCodeVisitor::generarCabecera(VarDecList* globales) {
+    if (!archivoFuente.empty()) out << ".file 1 " << entreComillas(archivoFuente) << '\n';
+    out << ".data\n";
+    globales->accept(this);
+
+    for (auto& [var, _] : memoriaGlobal) {
+        auto arreglo = longitudGlobal.find(var);
+        // alineados para las cargas empaquetadas de 32 bytes
+        if (arreglo != longitudGlobal.end()) out << ".align 32\n" << var << ": .zero " << 8L * arreglo->second << '\n';
+        else out << var << ": .quad 0\n";
+    }
+
+    out << ".text\n";
+}
+
+// Tamaño del buffer de salida de print.
+static const int TAMANO_SALIDA = 1 << 16;
+
+// Runtime de print, al final de cada programa. lab20_imprimir recibe el
+// valor en %rdi y lo agrega al buffer con el mismo formato que tenía
+// printf("%ld \n"): los dígitos salen de a pares de lab20_digitos, de
+// derecha a izquierda, en la zona roja; después se copian 24 bytes fijos al
+// buffer (el número más largo ocupa 23), que siempre tiene ese lugar libre.
+// lab20_vaciar_salida lo escribe con write(2) cuando se llena y, desde
+// .fini_array, al salir de main. Las dos solo tocan registros que el
+// llamador no preserva y no necesitan la pila alineada.
+void GenCodeVisitor::generarRuntime() {
+    out << ".section .rodata\n"
+           "lab20_digitos: .ascii \"";
+    for (int i = 0; i < 100; i++) out << char('0' + i / 10) << char('0' + i % 10);
+    out << "\"\n"
+           ".local lab20_salida\n"
+           ".comm lab20_salida, " << TAMANO_SALIDA << ", 64\n"
+           ".local lab20_salida_usado\n"
+           ".comm lab20_salida_usado, 8, 8\n"
+           ".text\n"
+           ".type lab20_vaciar_salida, @function\n"
+           "lab20_vaciar_salida:\n"
+           " leaq lab20_salida(%rip), %rsi\n"
+           " movq lab20_salida_usado(%rip), %rdx\n"
+           ".Lsalida_otro:\n"
+           " testq %rdx, %rdx\n"
+           " je .Lsalida_fin\n"
+           " movl $1, %eax\n"           // SYS_write
+           " movl $1, %edi\n"
+           " syscall\n"
+           " cmpq $-4, %rax\n"          // EINTR: se reintenta
+           " je .Lsalida_otro\n"
+           " testq %rax, %rax\n"
+           " jle .Lsalida_fin\n"
+           " addq %rax, %rsi\n"
+           " subq %rax, %rdx\n"
+           " jmp .Lsalida_otro\n"
+           ".Lsalida_fin:\n"
+           " movq $0, lab20_salida_usado(%rip)\n"
+           " ret\n"
+           ".size lab20_vaciar_salida, .-lab20_vaciar_salida\n"
+           ".type lab20_imprimir, @function\n"
+           "lab20_imprimir:\n"
+           " cmpq $" << TAMANO_SALIDA - 24 << ", lab20_salida_usado(%rip)\n"
+           " jbe .Limprimir_lugar\n"
+           " movq %rdi, %r8\n"
+           " call lab20_vaciar_salida\n"
+           " movq %r8, %rdi\n"
+           ".Limprimir_lugar:\n"
+           " movw $0x0a20, -2(%rsp)\n"  // " \n"
+           " leaq -2(%rsp), %rsi\n"
+           " movq %rdi, %rax\n"
+           " negq %rax\n"               // |v| sin signo, también para el mínimo
+           " cmovsq %rdi, %rax\n"
+           " leaq lab20_digitos(%rip), %r8\n"
+           " movabsq $0x28f5c28f5c28f5c3, %r9\n"
+           ".Limprimir_par:\n"
+           " cmpq $100, %rax\n"
+           " jb .Limprimir_ultimos\n"
+           " movq %rax, %rcx\n"         // %rcx = v, %rax = v / 100
+           " shrq $2, %rax\n"
+           " mulq %r9\n"
+           " movq %rdx, %rax\n"
+           " shrq $2, %rax\n"
+           " imulq $100, %rax, %rdx\n"
+           " subq %rdx, %rcx\n"
+           " movzwl (%r8,%rcx,2), %ecx\n"
+           " subq $2, %rsi\n"
+           " movw %cx, (%rsi)\n"
+           " jmp .Limprimir_par\n"
+           ".Limprimir_ultimos:\n"
+           " cmpq $10, %rax\n"
+           " jb .Limprimir_uno\n"
+           " movzwl (%r8,%rax,2), %ecx\n"
+           " subq $2, %rsi\n"
+           " movw %cx, (%rsi)\n"
+           " jmp .Limprimir_signo\n"
+           ".Limprimir_uno:\n"
+           " addb $'0', %al\n"
+           " decq %rsi\n"
+           " movb %al, (%rsi)\n"
+           ".Limprimir_signo:\n"
+           " testq %rdi, %rdi\n"
+           " jns .Limprimir_copiar\n"
+           " decq %rsi\n"
+           " movb $'-', (%rsi)\n"
+           ".Limprimir_copiar:\n"
+           " leaq lab20_salida(%rip), %rdi\n"
+           " addq lab20_salida_usado(%rip), %rdi\n"
+           " movq (%rsi), %rax\n"
+           " movq %rax, (%rdi)\n"
+           " movq 8(%rsi), %rax\n"
+           " movq %rax, 8(%rdi)\n"
+           " movq 16(%rsi), %rax\n"
+           " movq %rax, 16(%rdi)\n"
+           " movq %rsp, %rax\n"
+           " subq %rsi, %rax\n"
+           " addq %rax, lab20_salida_usado(%rip)\n"
+           " ret\n"
+           ".size lab20_imprimir, .-lab20_imprimir\n"
+           ".section .fini_array,\"aw\"\n"
+           " .align 8\n"
+           " .quad lab20_vaciar_salida\n";
+}
+
+// Con --profile-generate el pie agrega la rutina que vuelca los contadores.
+// Cada función deja los suyos en la sección lab20_perfil como pares
+// (cuenta, clave); el enlazador delimita la sección con __start_/__stop_ y
+// .fini_array hace que la rutina corra al salir de main.
+void GenCodeVisitor::generarPie() {
+    generarRuntime();
+    if (!rutaPerfil.empty()) {
+        out << ".section .rodata\n"
+               "perfil_ruta: .string " << entreComillas(rutaPerfil) << "\n"
+               "perfil_modo: .string \"w\"\n"
+               "perfil_fmt: .string \"%s %ld\\n\"\n"
+               ".text\n"
+               ".type lab20_volcar_perfil, @function\n"
+               "lab20_volcar_perfil:\n"
+               " pushq %rbx\n"
+               " pushq %r12\n"
+               " pushq %r13\n"
+               " leaq perfil_ruta(%rip), %rdi\n"
+               " leaq perfil_modo(%rip), %rsi\n"
+               " call fopen@PLT\n"
+               " testq %rax, %rax\n"
+               " je .Lperfil_fin\n"
+               " movq %rax, %r12\n"
+               " leaq __start_lab20_perfil(%rip), %rbx\n"
+               " leaq __stop_lab20_perfil(%rip), %r13\n"
+               ".Lperfil_otro:\n"
+               " cmpq %r13, %rbx\n"
+               " jae .Lperfil_cerrar\n"
+               " movq %r12, %rdi\n"
+               " leaq perfil_fmt(%rip), %rsi\n"
+               " movq 8(%rbx), %rdx\n"
+               " movq (%rbx), %rcx\n"
+               " movl $0, %eax\n"
+               " call fprintf@PLT\n"
+               " addq $16, %rbx\n"
+               " jmp .Lperfil_otro\n"
+               ".Lperfil_cerrar:\n"
+               " movq %r12, %rdi\n"
+               " call fclose@PLT\n"
+               ".Lperfil_fin:\n"
+               " popq %r13\n"
+               " popq %r12\n"
+               " popq %rbx\n"
+               " ret\n"
+               ".size lab20_volcar_perfil, .-lab20_volcar_perfil\n"
+               ".section .fini_array,\"aw\"\n"
+               " .align 8\n"
+               " .quad lab20_volcar_perfil\n";
+    }
+    out << ".section .note.GNU-stack,\"\",@progbits\n";
+}
+
+// Las instrucciones que siguen se atribuyen a esa posición del fuente
+// (perf annotate, addr2line).
+void GenCodeVisitor::ubicar(int linea, int columna) {
+    if (archivoFuente.empty() || linea <= 0) return;
+    out << " .loc 1 " << linea << ' ' << columna << '\n';
+}
+
+void GenCodeVisitor::contar(int sitio, const char* contador) {
+    if (rutaPerfil.empty() || sitio < 0) return;
+    out << " incq .Lperfil_" << nombreFuncion << "_" << (int) contadores.size() << "(%rip)\n";
+    contadores.push_back(to_string(sitio) + " " + contador);
+}
+
+void GenCodeVisitor::generarContadores(FunDec* f) {
+    if (rutaPerfil.empty()) return;
+    out << ".section lab20_perfil,\"aw\"\n .align 8\n";
+    int n = (int) contadores.size();
+    for (int i = 0; i < n; i++) {
+        out << ".Lperfil_" << nombreFuncion << "_" << i << ": .quad 0, .Lclave_" << nombreFuncion << "_" << i << '\n';
+    }
+    // no se incrementa: registra cuántos sitios tenía la función al medirla
+    out << " .quad " << f->sitios << ", .Lclave_" << nombreFuncion << "_" << n << '\n';
+    contadores.push_back("0 sitios");
+    out << ".section .rodata\n";
+    for (int i = 0; i <= n; i++) {
+        out << ".Lclave_" << nombreFuncion << "_" << i << ": .string \"" << nombreFuncion << ' ' << contadores[i] << "\"\n";
+    }
+    out << ".text\n";
+    contadores.clear();
+}
+
+CuentasSitio GenCodeVisitor::cuentas(int sitio) const {
+    return perfilFuncion ? perfilFuncion->sitio(sitio) : CuentasSitio{0, 0};
+}
+
+void GenCodeVisitor::visit(VarDec* stm) {
+    for (auto var : stm->vars) {
+        if (!entornoFuncion) {
+            memoriaGlobal[var] = true;
+            if (stm->longitud) longitudGlobal[var] = stm->longitud;
+        } else {
+            if (stm->longitud) offset -= 8 * (stm->longitud - 1);
+            memoria[var] = offset;
+            offset -= 8;
+        }
+    }
+}
+
+void GenCodeVisitor::visit(VarDecList* stm) {
+    for (auto dec : stm->vardecs)
+        dec->accept(this);
+}
+
+int GenCodeVisitor::visit(NumberExp* exp) {
+    out << " movq $" << exp->value << ", %rax\n";
+    return 0;
+}
+
+int GenCodeVisitor::visit(IdentifierExp* exp) {
+    out << " movq ";
+    variable(exp->name);
+    out << ", %rax\n";
+    return 0;
+}
+
+int GenCodeVisitor::visit(BinaryExp* exp) {
+    evaluar(exp);
+    return 0;
+}
+
+int GenCodeVisitor::visit(IndexExp* exp) {
+    evaluar(exp);
+    return 0;
+}
+
+int GenCodeVisitor::visit(IfExp* exp) {
+    evaluar(exp);
+    return 0;
+}
+
+// Orden de evaluación de una BinaryExp según las etiquetas de Sethi-Ullman.
+// DIRECTO: el hijo derecho es una hoja, basta %rcx como temporal.
+// OPERANDO: comparación o división con el hijo derecho hoja; se usa tal
+// cual como operando de cmpq (o se carga en %rcx para idivq).
+// IZQUIERDO/DERECHO: se evalúa primero ese hijo y se guarda en la pila.
+enum OrdenBinaria { DIRECTO, OPERANDO, IZQUIERDO, DERECHO };
+
+static bool esComparacion(BinaryOp op) {
+    return op == LT_OP || op == LE_OP || op == EQ_OP;
+}
+
+static OrdenBinaria ordenDe(BinaryExp* exp) {
+    if (exp->op != PLUS_OP && exp->op != MUL_OP) {
+        if (exp->op != MINUS_OP && exp->right->esHoja()) return OPERANDO;
+        return IZQUIERDO;
+    }
+    int l = exp->left->etiqueta;
+    int r = exp->right->etiqueta;
+    if (r == 0) return DIRECTO;
+    if (r > l) return DERECHO;
+    return IZQUIERDO;
+}
+
+static const char* const ARG_REGS[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+
+// Condición contraria para jcc/cmovcc.
+static const char* negada(const char* cc) {
+    string_view c = cc;
+    if (c == "l") return "ge";
+    if (c == "le") return "g";
+    if (c == "e") return "ne";
+    return "e";
+}
+
+// Un argumento hoja se carga al final, justo antes del call. Una global no
+// puede esperar si detrás hay otra llamada que podría modificarla.
+bool GenCodeVisitor::diferido(const vector<Exp*>& args, size_t i, int ultima) {
+    Exp* arg = args[i];
+    if (!arg->esHoja()) return false;
+    if ((int) i > ultima || arg->kind != IDENTIFIER_EXP) return true;
+    return !memoriaGlobal.count(static_cast<IdentifierExp*>(arg)->name);
+}
+
+void GenCodeVisitor::variable(const string& nombre) {
+    auto registro = enRegistro.find(nombre);
+    if (registro != enRegistro.end()) out << registro->second;
+    else if (memoriaGlobal.count(nombre)) out << nombre << "(%rip)";
+    else out << memoria[nombre] << marco;
+}
+
+void GenCodeVisitor::operando(Exp* hoja) {
+    if (hoja->kind == NUMBER_EXP) {
+        out << "$" << static_cast<NumberExp*>(hoja)->value;
+    } else if (hoja->kind == BOOL_EXP) {
+        out << "$" << static_cast<BoolExp*>(hoja)->value;
+    } else {
+        variable(static_cast<IdentifierExp*>(hoja)->name);
+    }
+}
+
+// Un elemento se direcciona como base + 8*índice. Con código PIC una
+// global no admite registro de índice junto a %rip, así que antes se deja
+// su dirección en %rdx; una local usa el registro del marco.
+void GenCodeVisitor::prepararElemento(const string& arreglo) {
+    if (memoriaGlobal.count(arreglo)) out << " leaq " << arreglo << "(%rip), %rdx\n";
+}
+
+void GenCodeVisitor::elemento(const string& arreglo, string_view indice) {
+    if (memoriaGlobal.count(arreglo)) out << "(%rdx," << indice << ",8)";
+    else out << memoria[arreglo] << marco.substr(0, 5) << "," << indice << ",8)";
+}
+
+// Temporales de evaluar(). En una función hoja no se usa push/pop: van en
+// la zona roja debajo de las locales y %rsp no se mueve.
+void GenCodeVisitor::apilar() {
+    profundidad += 8;
+    if (hoja) out << " movq %rax, " << -(baseTemporales + profundidad) << "(%rsp)\n";
+    else out << " pushq %rax\n";
+}
+
+void GenCodeVisitor::desapilar() {
+    if (hoja) out << " movq " << -(baseTemporales + profundidad) << "(%rsp), %rax\n";
+    else out << " popq %rax\n";
+    profundidad -= 8;
+}
+
+// Deja el valor de la expresión en %rax. Las BinaryExp y las llamadas se
+// recorren con una pila explícita (cada marco recuerda por qué hijo va), así
+// que la profundidad del árbol no consume pila del proceso. Con soloFlags,
+// una comparación en la raíz termina en el cmpq y deja el resultado en los
+// flags para un salto condicional.
+void GenCodeVisitor::evaluar(Exp* raiz, bool soloFlags) {
+    if (raiz->esHoja()) {
+        raiz->accept(this);
+        return;
+    }
+    vector<MarcoExp>& pila = pilaExp;
+    size_t base = pila.size();
+    pila.push_back({raiz, 0});
+    while (pila.size() > base) {
+        MarcoExp& m = pila.back();
+        if (m.e->kind == BINARY_EXP) {
+            BinaryExp* exp = static_cast<BinaryExp*>(m.e);
+            OrdenBinaria orden = ordenDe(exp);
+            Exp* primero = orden == DERECHO ? exp->right : exp->left;
+            Exp* segundo = orden == DERECHO ? exp->left : exp->right;
+            if (m.etapa == 0) {
+                m.etapa = 1;
+                if (!primero->esHoja()) {
+                    pila.push_back({primero, 0});
+                    continue;
+                }
+                primero->accept(this);
+            }
+            if (m.etapa == 1 && orden != OPERANDO) {
+                m.etapa = 2;
+                if (orden == DIRECTO) out << " movq %rax, %rcx\n";
+                else apilar();
+                if (!segundo->esHoja()) {
+                    pila.push_back({segundo, 0});
+                    continue;
+                }
+                segundo->accept(this);
+            }
+            if (orden == IZQUIERDO || orden == DERECHO) {
+                out << " movq %rax, %rcx\n";
+                desapilar();
+                if (orden == DERECHO) out << " xchgq %rax, %rcx\n";
+            }
+            if (esComparacion(exp->op)) {
+                out << " cmpq ";
+                if (orden == OPERANDO) operando(segundo);
+                else out << "%rcx";
+                out << ", %rax\n";
+            } else if (orden == OPERANDO) {
+                out << " movq ";
+                operando(segundo);
+                out << ", %rcx\n";
+            }
+            // un bool se produce con setcc sobre %al; si va directo a un
+            // salto ni siquiera eso
+            const char* cc = nullptr;
+            switch (exp->op) {
+                case PLUS_OP:
+                    out << " addq %rcx, %rax\n"; break;
+
+                case MUL_OP:
+                    out << " imulq %rcx, %rax\n"; break;
+
+                case MINUS_OP:
+                    out << " subq %rcx, %rax\n"; break;
+
+                case DIV_OP:
+                    out << " cqto\n"
+                        << " idivq %rcx\n"; break;
+
+                case LE_OP: cc = "le"; break;
+                case LT_OP: cc = "l"; break;
+                case EQ_OP: cc = "e"; break;
+            }
+            if (cc && !(soloFlags && m.e == raiz)) {
+                out << " set" << string_view(cc) << " %al\n"
+                    << " movzbl %al, %eax\n";
+            }
+        } else if (m.e->kind == INDEX_EXP) {
+            // el índice queda en %rax; la carga no toca %rcx
+            IndexExp* exp = static_cast<IndexExp*>(m.e);
+            if (m.etapa == 0) {
+                m.etapa = 1;
+                if (!exp->indice->esHoja()) {
+                    pila.push_back({exp->indice, 0});
+                    continue;
+                }
+                exp->indice->accept(this);
+            }
+            prepararElemento(exp->nombre);
+            out << " movq ";
+            elemento(exp->nombre, "%rax");
+            out << ", %rax\n";
+        } else if (m.e->kind == IF_EXP) {
+            // Con cmov: primero las ramas que no son hojas, apiladas; la
+            // condición queda en los flags, que ni popq ni movq tocan, y
+            // cmovq elige entre entonces (%rax) y sino (%rcx). Si no, saltos
+            // como un if y solo se evalúa la rama elegida; m.base guarda la
+            // etiqueta.
+            IfExp* exp = static_cast<IfExp*>(m.e);
+            Exp* entonces = exp->entonces;
+            Exp* sino = exp->sino;
+            if (exp->cmov) {
+                if (m.etapa == 0) {
+                    m.etapa = 1;
+                    if (!entonces->esHoja()) {
+                        pila.push_back({entonces, 0});
+                        continue;
+                    }
+                }
+                if (m.etapa == 1) {
+                    m.etapa = 2;
+                    if (!entonces->esHoja()) apilar();
+                    if (!sino->esHoja()) {
+                        pila.push_back({sino, 0});
+                        continue;
+                    }
+                }
+                if (!sino->esHoja()) apilar();
+                // puede anidar otro evaluar(): m no se vuelve a usar
+                const char* cc = condicion(exp->condicion);
+                if (sino->esHoja()) {
+                    out << " movq ";
+                    operando(sino);
+                    out << ", %rcx\n";
+                } else {
+                    desapilar();
+                    out << " movq %rax, %rcx\n";
+                }
+                if (entonces->esHoja()) {
+                    out << " movq ";
+                    operando(entonces);
+                    out << ", %rax\n";
+                } else {
+                    desapilar();
+                }
+                out << " cmov" << string_view(negada(cc)) << "q %rcx, %rax\n";
+            } else {
+                if (m.etapa == 0) {
+                    int label = labelcont++;
+                    const char* cc = condicion(exp->condicion);
+                    out << " j" << string_view(negada(cc)) << " ifexp_sino_" << nombreFuncion << "_" << label << '\n';
+                    MarcoExp& actual = pila.back();
+                    actual.base = label;
+                    actual.etapa = 1;
+                    if (!entonces->esHoja()) {
+                        pila.push_back({entonces, 0});
+                        continue;
+                    }
+                    entonces->accept(this);
+                }
+                MarcoExp& actual = pila.back();
+                if (actual.etapa == 1) {
+                    actual.etapa = 2;
+                    out << " jmp ifexp_fin_" << nombreFuncion << "_" << actual.base << '\n';
+                    out << "ifexp_sino_" << nombreFuncion << "_" << actual.base << ":\n";
+                    if (!sino->esHoja()) {
+                        pila.push_back({sino, 0});
+                        continue;
+                    }
+                    sino->accept(this);
+                }
+                out << "ifexp_fin_" << nombreFuncion << "_" << pila.back().base << ":\n";
+            }
+        } else {
+            // Convención SysV: los argumentos se evalúan de izquierda a
+            // derecha en temporales (la pila, o directamente su hueco si van
+            // por pila) y al final se mueven a la vez a %rdi..%r9, así
+            // evaluar uno no pisa los anteriores. Las hojas no se evalúan
+            // antes: se cargan directamente en su registro.
+            FCallExp* exp = static_cast<FCallExp*>(m.e);
+            auto& args = exp->argumentos;
+            size_t n = args.size();
+            if (m.etapa == 0) {
+                m.area = 8 * (int) (n > 6 ? n - 6 : 0);
+                if ((profundidad + m.area) % 16) m.area += 8;
+                if (m.area) out << " subq $" << m.area << ", %rsp\n";
+                profundidad += m.area;
+                m.base = profundidad;
+                m.ultima = -1;
+                for (size_t i = n; i-- > 0; ) {
+                    if (!args[i]->esHoja()) {
+                        m.ultima = (int) i;
+                        break;
+                    }
+                }
+            }
+            // etapa i: los argumentos 0..i-1 ya se evaluaron
+            bool pendiente = false;
+            while (true) {
+                if (m.etapa > 0 && !diferido(args, m.etapa - 1, m.ultima)) {
+                    size_t i = m.etapa - 1;
+                    if (i >= 6) {
+                        out << " movq %rax, " << profundidad - m.base + 8 * (int) (i - 6) << "(%rsp)\n";
+                    } else if ((int) i == m.ultima) {
+                        out << " movq %rax, " << string_view(ARG_REGS[i]) << '\n';
+                    } else {
+                        apilar();
+                    }
+                }
+                if (m.etapa == n) break;
+                size_t i = m.etapa++;
+                if (diferido(args, i, m.ultima)) continue;
+                if (!args[i]->esHoja()) {
+                    pila.push_back({args[i], 0});
+                    pendiente = true;
+                    break;
+                }
+                args[i]->accept(this);
+            }
+            if (pendiente) continue;
+            for (size_t i = min(n, (size_t) 6); i-- > 0; ) {
+                if (!diferido(args, i, m.ultima) && (int) i != m.ultima) {
+                    out << " popq " << string_view(ARG_REGS[i]) << '\n';
+                    profundidad -= 8;
+                }
+            }
+            for (size_t i = 0; i < n; i++) {
+                if (!diferido(args, i, m.ultima)) continue;
+                out << " movq ";
+                operando(args[i]);
+                if (i < 6) {
+                    out << ", " << string_view(ARG_REGS[i]) << '\n';
+                } else if (args[i]->kind == IDENTIFIER_EXP) {
+                    out << ", %rax\n movq %rax, " << 8 * (int) (i - 6) << "(%rsp)\n";
+                } else {
+                    out << ", " << 8 * (int) (i - 6) << "(%rsp)\n";
+                }
+            }
+            contar(exp->sitio, "llamadas");
+            out << "call " << exp->nombre << '\n';
+            if (m.area) out << " addq $" << m.area << ", %rsp\n";
+            profundidad -= m.area;
+        }
+        pila.pop_back();
+    }
+}
+
+void GenCodeVisitor::visit(AssignStatement* stm) {
+    ubicar(stm->linea, stm->columna);
+    stm->rhs->accept(this);
+    if (stm->indice) {
+        // a[i] = e: primero el valor, después el índice en %rcx
+        if (stm->indice->esHoja()) {
+            out << " movq ";
+            operando(stm->indice);
+            out << ", %rcx\n";
+        } else {
+            apilar();
+            stm->indice->accept(this);
+            out << " movq %rax, %rcx\n";
+            desapilar();
+        }
+        prepararElemento(stm->id);
+        out << " movq %rax, ";
+        elemento(stm->id, "%rcx");
+        out << '\n';
+        return;
+    }
+    out << " movq %rax, ";
+    variable(stm->id);
+    out << '\n';
+}
+
+void GenCodeVisitor::visit(PrintStatement* stm) {
+    ubicar(stm->linea, stm->columna);
+    stm->e->accept(this);
+    out << " movq %rax, %rdi\n"
+           "call lab20_imprimir\n";
+}
+
+
+
+
+
+
+
+void GenCodeVisitor::visit(FunDecList* f) {
+    for (auto dec : f->Fundecs)
+        dec->accept(this);
+}
+
+void GenCodeVisitor::visit(StatementList* stm) {
+    for (auto s : stm->stms)
+        s->accept(this);
+}
+
+void GenCodeVisitor::visit(Body* b) {
+    generarSentencias(b, nullptr);
+}
+
+void GenCodeVisitor::visit(IfStatement* stm) {
+    generarSentencias(nullptr, stm);
+}
+
+void GenCodeVisitor::visit(WhileStatement* stm) {
+    generarSentencias(nullptr, stm);
+}
+
+void GenCodeVisitor::visit(ForStatement* stm) {
+    generarSentencias(nullptr, stm);
+}
+
+// Deja una condición (un bool) en los flags y devuelve el sufijo de jcc o
+// cmovcc que corresponde a verdadera. Una comparación termina en su cmpq;
+// una variable se prueba en memoria con cmpb, o con cmpq si es una global
+// que el bucle lleva en un registro.
+const char* GenCodeVisitor::condicion(Exp* c) {
+    if (c->kind == IDENTIFIER_EXP) {
+        out << string_view(enRegistro.count(static_cast<IdentifierExp*>(c)->name) ? " cmpq $0, " : " cmpb $0, ");
+        operando(c);
+        out << '\n';
+        return "ne";
+    }
+    if (c->kind == BINARY_EXP && esComparacion(static_cast<BinaryExp*>(c)->op)) {
+        evaluar(c, true);
+        switch (static_cast<BinaryExp*>(c)->op) {
+            case LT_OP: return "l";
+            case LE_OP: return "le";
+            default: return "e";
+        }
+    }
+    // un bool ya verificado vale 0 o 1; basta probar el byte bajo
+    c->accept(this);
+    if (c->tipo == TIPO_BOOL) out << " testb %al, %al\n";
+    else out << " testq %rax, %rax\n";
+    return "ne";
+}
+
+// Salta a <destino><función>_<label> si la condición (un bool) vale
+// siVerdadera.
+void GenCodeVisitor::saltar(Exp* condicion, bool siVerdadera, const char* destino, int label) {
+    if (condicion->kind == BOOL_EXP) {
+        if ((static_cast<BoolExp*>(condicion)->value != 0) != siVerdadera) return;
+        out << " jmp";
+    } else {
+        const char* cc = this->condicion(condicion);
+        out << " j" << string_view(siVerdadera ? cc : negada(cc));
+    }
+    out << ' ' << string_view(destino) << nombreFuncion << "_" << label << '\n';
+}
+
+static const char* const BASES_VECTORIALES[] = {"%rsi", "%rdi", "%r8", "%r9", "%r10", "%r11"};
+
+// Las vueltas de un BucleVectorial que caben enteras, antes del while que
+// queda como epílogo escalar. Durante el bucle i va en %rax, el límite
+// menos ancho-1 en %rcx, la base de cada arreglo en BASES_VECTORIALES y
+// cada término invariante repetido en todos los carriles desde %xmm3; el
+// valor se arma en %xmm0 y una reducción acumula en %xmm2. Con AVX2 los
+// mismos registros son %ymm y las operaciones VEX aceptan memoria sin
+// alinear, así que los elementos se suman directo desde memoria.
+void GenCodeVisitor::generarVectorial(WhileStatement* w) {
+    const BucleVectorial& v = *w->vectorial;
+    BinaryExp* cond = static_cast<BinaryExp*>(w->condition);
+    bool avx = v.ancho == 4;
+    string_view r = avx ? "%ymm" : "%xmm";
+    int label = labelcont++;
+
+    out << " movq ";
+    variable(v.variable);
+    out << ", %rax\n movq ";
+    operando(cond->right);
+    out << ", %rcx\n subq $" << v.ancho - 1 << ", %rcx\n";
+
+    vector<pair<string, const char*>> bases;
+    auto base = [&](const string& arreglo) {
+        for (auto& [nombre, registro] : bases) {
+            if (nombre == arreglo) return registro;
+        }
+        const char* registro = BASES_VECTORIALES[bases.size()];
+        bases.push_back({arreglo, registro});
+        if (memoriaGlobal.count(arreglo)) out << " leaq " << arreglo << "(%rip), ";
+        else out << " leaq " << memoria[arreglo] << marco << ", ";
+        out << string_view(registro) << '\n';
+        return registro;
+    };
+    // registro vectorial de cada término (0: se lee de memoria)
+    vector<int> registros;
+    int invariantes = 3;
+    for (auto& t : v.terminos) {
+        if (t.clase == BucleVectorial::Termino::ELEMENTO) {
+            base(t.nombre);
+            registros.push_back(0);
+            continue;
+        }
+        out << " movq ";
+        if (t.clase == BucleVectorial::Termino::CONSTANTE) out << "$" << t.valor;
+        else variable(t.nombre);
+        out << ", %rdx\n";
+        if (avx) {
+            out << " vmovq %rdx, %xmm" << invariantes << "\n"
+                << " vpbroadcastq %xmm" << invariantes << ", %ymm" << invariantes << '\n';
+        } else {
+            out << " movq %rdx, %xmm" << invariantes << "\n"
+                << " punpcklqdq %xmm" << invariantes << ", %xmm" << invariantes << '\n';
+        }
+        registros.push_back(invariantes++);
+    }
+    bool reduccion = v.destino.empty();
+    if (!reduccion) base(v.destino);
+    else if (avx) out << " vpxor %ymm2, %ymm2, %ymm2\n";
+    else out << " pxor %xmm2, %xmm2\n";
+
+    string_view sigue = cond->op == LT_OP ? "jl" : "jle";
+    out << " cmpq %rcx, %rax\n"
+        << ' ' << string_view(cond->op == LT_OP ? "jge" : "jg") << " endvec_" << nombreFuncion << "_" << label << '\n';
+    out << "vec_" << nombreFuncion << "_" << label << ":\n";
+    // destino = acumulador (%xmm2) en una reducción; si no, %xmm0
+    int destino = reduccion ? 2 : 0;
+    for (size_t k = 0; k < v.terminos.size(); k++) {
+        auto& t = v.terminos[k];
+        bool primero = k == 0 && !reduccion;
+        string_view op = primero ? "" : t.resta ? "psubq" : "paddq";
+        if (registros[k] == 0) {
+            const char* b = base(t.nombre);
+            if (avx) {
+                if (primero) out << " vmovdqu (" << string_view(b) << ",%rax,8), %ymm0\n";
+                else out << " v" << op << " (" << string_view(b) << ",%rax,8), %ymm" << destino << ", %ymm" << destino << '\n';
+            } else if (primero) {
+                out << " movdqu (" << string_view(b) << ",%rax,8), %xmm0\n";
+            } else {
+                out << " movdqu (" << string_view(b) << ",%rax,8), %xmm1\n"
+                    << ' ' << op << " %xmm1, %xmm" << destino << '\n';
+            }
+        } else if (primero) {
+            out << string_view(avx ? " vmovdqa " : " movdqa ") << r << registros[k] << ", " << r << "0\n";
+        } else if (avx) {
+            out << " v" << op << " %ymm" << registros[k] << ", %ymm" << destino << ", %ymm" << destino << '\n';
+        } else {
+            out << ' ' << op << " %xmm" << registros[k] << ", %xmm" << destino << '\n';
+        }
+    }
+    if (!reduccion) {
+        out << string_view(avx ? " vmovdqu " : " movdqu ") << r << "0, (" << string_view(base(v.destino)) << ",%rax,8)\n";
+    }
+    out << " addq $" << v.ancho << ", %rax\n"
+        << " cmpq %rcx, %rax\n"
+        << ' ' << sigue << " vec_" << nombreFuncion << "_" << label << '\n';
+    out << "endvec_" << nombreFuncion << "_" << label << ":\n";
+    out << " movq %rax, ";
+    variable(v.variable);
+    out << '\n';
+    if (reduccion) {
+        // suma horizontal de los carriles
+        if (avx) {
+            out << " vextracti128 $1, %ymm2, %xmm0\n"
+                   " vpaddq %xmm0, %xmm2, %xmm2\n"
+                   " vpshufd $0x4e, %xmm2, %xmm0\n"
+                   " vpaddq %xmm0, %xmm2, %xmm2\n"
+                   " vmovq %xmm2, %rdx\n";
+        } else {
+            out << " pshufd $0x4e, %xmm2, %xmm0\n"
+                   " paddq %xmm0, %xmm2\n"
+                   " movq %xmm2, %rdx\n";
+        }
+        out << " addq %rdx, ";
+        variable(v.acumulador);
+        out << '\n';
+    }
+    // sin esto el código SSE que sigue (libc) paga la transición de AVX
+    if (avx) out << " vzeroupper\n";
+}
+
+// Bloques anidados sin recursión. Un marco es un Body por abrir o una
+// sentencia if/while/for en alguna de sus etapas (0: antes de la condición,
+// 1: después del primer bloque, 2: después del else).
+void GenCodeVisitor::generarSentencias(Body* cuerpo, Stm* stm) {
+    vector<MarcoStm>& pila = pilaStm;
+    size_t base = pila.size();
+    pila.push_back({cuerpo, stm, 0, 0});
+    while (pila.size() > base) {
+        MarcoStm m = pila.back();
+        pila.pop_back();
+        if (m.cuerpo) {
+            m.cuerpo->vardecs->accept(this);
+            auto& stms = m.cuerpo->slist->stms;
+            for (auto it = stms.rbegin(); it != stms.rend(); ++it) {
+                pila.push_back({nullptr, *it, 0, 0});
+            }
+        } else if (m.stm->kind == IF_STM) {
+            IfStatement* s = static_cast<IfStatement*>(m.stm);
+            if (m.etapa == 0) {
+                ubicar(s->linea, s->columna);
+                int label = labelcont++;
+                // con perfil, la rama más ejecutada sigue al salto sin tomarlo
+                CuentasSitio c = cuentas(s->sitio);
+                bool invertido = s->els && c[1] > c[0];
+                if (invertido) saltar(s->condition, true, "then_", label);
+                else saltar(s->condition, false, "else_", label);
+                contar(s->sitio, invertido ? "else" : "then");
+                pila.push_back({nullptr, s, 1, label, invertido});
+                pila.push_back({invertido ? s->els : s->then, nullptr, 0, 0});
+            } else if (m.etapa == 1) {
+                out << " jmp endif_" << nombreFuncion << "_" << m.label << '\n';
+                if (m.invertido) out << "then_" << nombreFuncion << "_" << m.label << ":\n";
+                else out << " else_" << nombreFuncion << "_" << m.label << ":\n";
+                contar(s->sitio, m.invertido ? "then" : "else");
+                pila.push_back({nullptr, s, 2, m.label});
+                Body* segundo = m.invertido ? s->then : s->els;
+                if (segundo) pila.push_back({segundo, nullptr, 0, 0});
+            } else {
+                out << "endif_" << nombreFuncion << "_" << m.label << ":\n";
+            }
+        } else if (m.stm->kind == WHILE_STM) {
+            WhileStatement* s = static_cast<WhileStatement*>(m.stm);
+            if (m.etapa == 0) {
+                ubicar(s->linea, s->columna);
+                abrirRegion(s);
+                if (s->vectorial) generarVectorial(s);
+                int label = labelcont++;
+                contar(s->sitio, "entradas");
+                // un bucle que da vueltas según el perfil se rota: la
+                // condición va al final y cada vuelta cuesta un solo salto
+                CuentasSitio c = cuentas(s->sitio);
+                bool rotado = c[1] > c[0];
+                if (rotado) {
+                    out << " jmp condwhile_" << nombreFuncion << "_" << label << '\n';
+                    out << "while_" << nombreFuncion << "_" << label << ":\n";
+                } else {
+                    out << "while_" << nombreFuncion << "_" << label << ":\n";
+                    saltar(s->condition, false, "endwhile_", label);
+                }
+                contar(s->sitio, "vueltas");
+                pila.push_back({nullptr, s, 1, label, rotado});
+                pila.push_back({s->b, nullptr, 0, 0});
+            } else if (m.invertido) {
+                out << "condwhile_" << nombreFuncion << "_" << m.label << ":\n";
+                ubicar(s->linea, s->columna);
+                saltar(s->condition, true, "while_", m.label);
+                cerrarRegion(s);
+            } else {
+                out << " jmp while_" << nombreFuncion << "_" << m.label << '\n';
+                out << "endwhile_" << nombreFuncion << "_" << m.label << ":\n";
+                cerrarRegion(s);
+            }
+        } else if (m.stm->kind == FOR_STM) {
+            ForStatement* s = static_cast<ForStatement*>(m.stm);
+            ubicar(s->linea, s->columna);
+            if (m.etapa == 0) {
+                int label = labelcont++;
+                abrirRegion(s);
+                abrirFor(s, label);
+                pila.push_back({nullptr, s, 1, label});
+                pila.push_back({s->b, nullptr, 0, 0});
+            } else {
+                cerrarFor(m.label);
+                cerrarRegion(s);
+            }
+        } else {
+            m.stm->accept(this);
+        }
+    }
+}
+
+int GenCodeVisitor::visit(BoolExp* exp) {
+    out << " movl $" << exp->value << ", %eax\n";
+    return 0;
+}
+
+void GenCodeVisitor::visit(ReturnStatement* stm) {
+    ubicar(stm->linea, stm->columna);
+    stm->e->accept(this);
+    guardarGlobales();
+    if (hoja) {
+        restaurarRegistros();
+        out << "ret\n";
+    } else {
+        out << " jmp .end_"<<nombreFuncion << '\n';
+    }
+}
+
+// Registros de las variables y los límites de los for, por orden de
+// anidamiento. Son callee-saved: las llamadas del cuerpo no los pisan y la
+// función que los usa los guarda en su marco. Los que sobran en un bucle
+// sin llamadas llevan sus globales (analizarCuerpo).
+static const char* const REGISTROS_FOR[] = {"%rbx", "%r12", "%r13", "%r14", "%r15"};
+static const int MAX_REGISTROS_FOR = 5;
+
+// Reparto de registros de un for cuando ya hay `tomados` ocupados por los
+// que lo encierran. analizarCuerpo() y abrirFor() lo calculan igual.
+struct RepartoFor {
+    bool variable;      // la variable va en registro
+    bool limite;        // el límite va en registro
+    bool hueco;         // el límite va en un hueco del marco
+};
+
+static RepartoFor repartir(ForStatement* f, int tomados, const unordered_map<string, bool>& globales) {
+    RepartoFor r{false, false, false};
+    if (!globales.count(f->variable) && tomados < MAX_REGISTROS_FOR) {
+        r.variable = true;
+        tomados++;
+    }
+    if (f->fin->kind != NUMBER_EXP) {
+        r.limite = tomados < MAX_REGISTROS_FOR;
+        r.hueco = !r.limite;
+    }
+    return r;
+}
+
+// for i = a, b: i toma a y después se evalúa b, una sola vez. Si ya se
+// pasó del límite no se entra; si no, el cuerpo va seguido de incq, cmpq y
+// un jle de vuelta, sin leer ni escribir memoria cuando la variable y el
+// límite están en registros. Al salir la variable vuelve a su lugar.
+void GenCodeVisitor::abrirFor(ForStatement* f, int label) {
+    MarcoFor m{f->variable, "", "", pilaFor.empty() ? 0 : pilaFor.back().tomados};
+    RepartoFor r = repartir(f, m.tomados, memoriaGlobal);
+    // una hoja va directo al registro
+    auto cargar = [&](Exp* e, string_view registro) {
+        if (e->esHoja()) {
+            out << " movq ";
+            operando(e);
+        } else {
+            evaluar(e);
+            out << " movq %rax";
+        }
+        out << ", " << registro << '\n';
+    };
+    if (r.variable) {
+        m.registro = REGISTROS_FOR[m.tomados++];
+        cargar(f->inicio, m.registro);
+        enRegistro[f->variable] = m.registro;
+    } else {
+        evaluar(f->inicio);
+        out << " movq %rax, ";
+        variable(f->variable);
+        out << '\n';
+    }
+    if (f->fin->kind == NUMBER_EXP) {
+        m.limite = "$" + to_string(static_cast<NumberExp*>(f->fin)->value);
+    } else if (r.limite) {
+        m.limite = REGISTROS_FOR[m.tomados++];
+        cargar(f->fin, m.limite);
+    } else {
+        evaluar(f->fin);
+        m.limite = to_string(offset) + string(marco);
+        offset -= 8;
+        out << " movq %rax, " << m.limite << '\n';
+    }
+    string_view i = m.registro;
+    if (i.empty()) {
+        out << " movq ";
+        variable(f->variable);
+        out << ", %rax\n";
+        i = "%rax";
+    }
+    out << " cmpq " << m.limite << ", " << i << '\n'
+        << " jg endfor_" << nombreFuncion << "_" << label << '\n'
+        << "for_" << nombreFuncion << "_" << label << ":\n";
+    pilaFor.push_back(m);
+}
+
+void GenCodeVisitor::cerrarFor(int label) {
+    MarcoFor m = pilaFor.back();
+    pilaFor.pop_back();
+    if (m.registro.empty()) {
+        out << " incq ";
+        variable(m.variable);
+        out << "\n movq ";
+        variable(m.variable);
+        out << ", %rax\n cmpq " << m.limite << ", %rax\n";
+    } else {
+        out << " incq " << m.registro << "\n"
+            << " cmpq " << m.limite << ", " << m.registro << '\n';
+    }
+    out << " jle for_" << nombreFuncion << "_" << label << '\n'
+        << "endfor_" << nombreFuncion << "_" << label << ":\n";
+    if (!m.registro.empty()) {
+        enRegistro.erase(m.variable);
+        out << " movq " << m.registro << ", ";
+        variable(m.variable);
+        out << '\n';
+    }
+}
+
+void GenCodeVisitor::restaurarRegistros() {
+    for (size_t i = 0; i < guardados.size(); i++) {
+        out << " movq " << guardados[i] << marco << ", " << string_view(REGISTROS_FOR[i]) << '\n';
+    }
+}
+
+void GenCodeVisitor::abrirRegion(Stm* bucle) {
+    auto r = regiones.find(bucle);
+    if (r == regiones.end()) return;
+    region = bucle;
+    for (auto& g : r->second) {
+        TRAZA(TRAZA_DEBUG, "codegen: " << nombreFuncion << " lleva " << g.nombre << " en " << g.registro);
+        out << " movq " << g.nombre << "(%rip), " << g.registro << '\n';
+        enRegistro[g.nombre] = g.registro;
+    }
+}
+
+void GenCodeVisitor::cerrarRegion(Stm* bucle) {
+    if (region != bucle) return;
+    guardarGlobales();
+    for (auto& g : regiones[bucle]) enRegistro.erase(g.nombre);
+    region = nullptr;
+}
+
+// Las globales que asigna el bucle abierto vuelven a memoria: al salir de
+// él o en un return dentro de él.
+void GenCodeVisitor::guardarGlobales() {
+    if (region == nullptr) return;
+    for (auto& g : regiones[region]) {
+        if (g.asignada) out << " movq " << g.registro << ", " << g.nombre << "(%rip)\n";
+    }
+}
+
+// Lo que hay dentro de un bucle que podría llevar globales en registros.
+// Sin llamadas ninguna otra función puede leerlas ni escribirlas mientras
+// corre; print sí puede estar, porque lab20_imprimir solo toca su buffer
+// y respeta los registros callee-saved.
+struct Region {
+    bool llamadas = false;
+    int registros = 0;                      // REGISTROS_FOR que ocupan sus for
+    unordered_map<string, int> usos;        // global -> apariciones
+    unordered_map<string, bool> asignadas;
+};
+
+static void explorar(Exp* raiz, const unordered_map<string, bool>& globales, Region& r) {
+    vector<Exp*> pendientes = {raiz};
+    while (!pendientes.empty()) {
+        Exp* e = pendientes.back();
+        pendientes.pop_back();
+        if (e->kind == IDENTIFIER_EXP) {
+            const string& nombre = static_cast<IdentifierExp*>(e)->name;
+            if (globales.count(nombre)) r.usos[nombre]++;
+        } else if (e->kind == BINARY_EXP) {
+            pendientes.push_back(static_cast<BinaryExp*>(e)->left);
+            pendientes.push_back(static_cast<BinaryExp*>(e)->right);
+        } else if (e->kind == FCALL_EXP) {
+            r.llamadas = true;
+            return;
+        } else if (e->kind == INDEX_EXP) {
+            pendientes.push_back(static_cast<IndexExp*>(e)->indice);
+        } else if (e->kind == IF_EXP) {
+            IfExp* x = static_cast<IfExp*>(e);
+            pendientes.push_back(x->condicion);
+            pendientes.push_back(x->entonces);
+            pendientes.push_back(x->sino);
+        }
+    }
+}
+
+static void explorar(Body* b, int tomados, const unordered_map<string, bool>& globales, Region& r);
+
+static void explorar(Stm* s, int tomados, const unordered_map<string, bool>& globales, Region& r) {
+    switch (s->kind) {
+        case ASSIGN_STM: {
+            AssignStatement* a = static_cast<AssignStatement*>(s);
+            if (!a->indice && globales.count(a->id)) {
+                r.usos[a->id]++;
+                r.asignadas[a->id] = true;
+            }
+            explorar(a->rhs, globales, r);
+            if (a->indice) explorar(a->indice, globales, r);
+            break;
+        }
+        case PRINT_STM:
+            explorar(static_cast<PrintStatement*>(s)->e, globales, r); break;
+        case RETURN_STM:
+            if (static_cast<ReturnStatement*>(s)->e) explorar(static_cast<ReturnStatement*>(s)->e, globales, r);
+            break;
+        case IF_STM: {
+            IfStatement* i = static_cast<IfStatement*>(s);
+            explorar(i->condition, globales, r);
+            explorar(i->then, tomados, globales, r);
+            if (i->els) explorar(i->els, tomados, globales, r);
+            break;
+        }
+        case WHILE_STM: {
+            WhileStatement* w = static_cast<WhileStatement*>(s);
+            explorar(w->condition, globales, r);
+            explorar(w->b, tomados, globales, r);
+            break;
+        }
+        case FOR_STM: {
+            ForStatement* f = static_cast<ForStatement*>(s);
+            if (globales.count(f->variable)) {
+                r.usos[f->variable]++;
+                r.asignadas[f->variable] = true;
+            }
+            explorar(f->inicio, globales, r);
+            explorar(f->fin, globales, r);
+            RepartoFor reparto = repartir(f, tomados, globales);
+            explorar(f->b, tomados + reparto.variable + reparto.limite, globales, r);
+            break;
+        }
+    }
+}
+
+static void explorar(Body* b, int tomados, const unordered_map<string, bool>& globales, Region& r) {
+    r.registros = max(r.registros, tomados);
+    for (auto s : b->slist->stms) explorar(s, tomados, globales, r);
+}
+
+// Lo que una función necesita de su marco: variables declaradas en el
+// cuerpo y en sus bloques anidados (más los huecos de los límites de for
+// que no entran en registros), el máximo de temporales que apila evaluar()
+// a la vez, cuántos REGISTROS_FOR usa y si es una hoja (no llama a nada,
+// tampoco a lab20_imprimir).
+struct UsoMarco {
+    int locales = 0;
+    int temporales = 0;
+    int registros = 0;
+    bool hoja = true;
+};
+
+// Deja en regiones los bucles sin llamadas más externos con las globales
+// que usan, las más nombradas primero, en los REGISTROS_FOR que no
+// necesitan sus for.
+static UsoMarco analizarCuerpo(Body* cuerpo, const unordered_map<string, bool>& globales,
+                               unordered_map<Stm*, vector<GlobalEnRegistro>>& regiones) {
+    UsoMarco uso;
+    // cada bloque con los registros que ya ocupan los for que lo encierran
+    // y si está dentro de un bucle que ya lleva globales en registros
+    struct Bloque {
+        Body* b;
+        int tomados;
+        bool enRegion;
+    };
+    vector<Bloque> pendientes = {{cuerpo, 0, false}};
+    vector<pair<Exp*, int>> exps;
+    auto buscarRegion = [&](Stm* bucle, int tomados) {
+        Region r;
+        explorar(bucle, tomados, globales, r);
+        if (r.llamadas || r.usos.empty()) return false;
+        vector<pair<string, int>> usos(r.usos.begin(), r.usos.end());
+        sort(usos.begin(), usos.end(), [](const pair<string, int>& a, const pair<string, int>& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        int libre = max(r.registros, tomados);
+        auto& promovidas = regiones[bucle];
+        for (auto& [nombre, _] : usos) {
+            if (libre == MAX_REGISTROS_FOR) break;
+            promovidas.push_back({nombre, REGISTROS_FOR[libre++], r.asignadas.count(nombre) > 0});
+        }
+        if (promovidas.empty()) {
+            regiones.erase(bucle);
+            return false;
+        }
+        uso.registros = max(uso.registros, libre);
+        return true;
+    };
+    while (!pendientes.empty()) {
+        auto [b, tomados, enRegion] = pendientes.back();
+        pendientes.pop_back();
+        uso.registros = max(uso.registros, tomados);
+        for (auto dec : b->vardecs->vardecs) uso.locales += dec->vars.size() * max(1, dec->longitud);
+        for (auto s : b->slist->stms) {
+            switch (s->kind) {
+                case ASSIGN_STM: {
+                    // un índice que no es hoja se evalúa con el valor apilado
+                    AssignStatement* a = static_cast<AssignStatement*>(s);
+                    exps.push_back({a->rhs, 0});
+                    if (a->indice) exps.push_back({a->indice, !a->indice->esHoja()});
+                    break;
+                }
+                case PRINT_STM:
+                    uso.hoja = false;
+                    exps.push_back({static_cast<PrintStatement*>(s)->e, 0}); break;
+                case RETURN_STM:
+                    exps.push_back({static_cast<ReturnStatement*>(s)->e, 0}); break;
+                case IF_STM: {
+                    IfStatement* si = static_cast<IfStatement*>(s);
+                    exps.push_back({si->condition, 0});
+                    pendientes.push_back({si->then, tomados, enRegion});
+                    if (si->els) pendientes.push_back({si->els, tomados, enRegion});
+                    break;
+                }
+                case WHILE_STM: {
+                    WhileStatement* sw = static_cast<WhileStatement*>(s);
+                    exps.push_back({sw->condition, 0});
+                    bool region = enRegion || buscarRegion(sw, tomados);
+                    pendientes.push_back({sw->b, tomados, region});
+                    break;
+                }
+                case FOR_STM: {
+                    ForStatement* sf = static_cast<ForStatement*>(s);
+                    exps.push_back({sf->inicio, 0});
+                    exps.push_back({sf->fin, 0});
+                    RepartoFor r = repartir(sf, tomados, globales);
+                    if (r.hueco) uso.locales++;
+                    bool region = enRegion || buscarRegion(sf, tomados);
+                    pendientes.push_back({sf->b, tomados + r.variable + r.limite, region});
+                    break;
+                }
+            }
+        }
+        // mismo orden de evaluación que evaluar(): en una BinaryExp que no
+        // es DIRECTO el primer operando queda apilado mientras se evalúa
+        // el segundo
+        while (!exps.empty()) {
+            auto [e, apilados] = exps.back();
+            exps.pop_back();
+            uso.temporales = max(uso.temporales, apilados);
+            if (e->kind == FCALL_EXP) {
+                uso.hoja = false;
+                for (auto arg : static_cast<FCallExp*>(e)->argumentos) exps.push_back({arg, 0});
+            } else if (e->kind == INDEX_EXP) {
+                exps.push_back({static_cast<IndexExp*>(e)->indice, apilados});
+            } else if (e->kind == IF_EXP) {
+                // con cmov las ramas que no son hojas quedan apiladas
+                // mientras se evalúa lo que sigue
+                IfExp* x = static_cast<IfExp*>(e);
+                int n = apilados;
+                bool cmov = x->cmov;
+                exps.push_back({x->entonces, n});
+                if (cmov && !x->entonces->esHoja()) n++;
+                exps.push_back({x->sino, n});
+                if (cmov && !x->sino->esHoja()) n++;
+                exps.push_back({x->condicion, n});
+                uso.temporales = max(uso.temporales, n);
+            } else if (e->kind == BINARY_EXP) {
+                BinaryExp* bin = static_cast<BinaryExp*>(e);
+                OrdenBinaria orden = ordenDe(bin);
+                exps.push_back({orden == DERECHO ? bin->right : bin->left, apilados});
+                exps.push_back({orden == DERECHO ? bin->left : bin->right, apilados + (orden == IZQUIERDO || orden == DERECHO)});
+            }
+        }
+    }
+    return uso;
+}
+
+// Una función hoja no arma marco: %rsp no se mueve en todo el cuerpo, así
+// que parámetros, locales y temporales se direccionan desde %rsp dentro de
+// la zona roja de 128 bytes que garantiza la ABI.
+static const int ZONA_ROJA = 128;
+
+// --memoize: la tabla de cada función memoizada tiene 1 << BITS_MEMO
+// entradas de 32 bytes: los argumentos, el resultado y si está ocupada.
+static const int BITS_MEMO = 12;
+
+// Deja en %rcx la entrada de los argumentos de f (hash multiplicativo con
+// la razón áurea, que reparte bien los enteros consecutivos). Usa %rdx.
+void GenCodeVisitor::entradaMemo(FunDec* f) {
+    out << " movabsq $0x9e3779b97f4a7c15, %rdx\n"
+           " movq ";
+    variable(f->parametros[0]);
+    out << ", %rcx\n"
+           " imulq %rdx, %rcx\n";
+    if (f->parametros.size() > 1) {
+        out << " addq ";
+        variable(f->parametros[1]);
+        out << ", %rcx\n"
+               " imulq %rdx, %rcx\n";
+    }
+    out << " shrq $" << 64 - BITS_MEMO << ", %rcx\n"
+           " shlq $5, %rcx\n"
+           " leaq lab20_memo_" << f->nombre << "(%rip), %rdx\n"
+           " addq %rdx, %rcx\n";
+}
+
+void GenCodeVisitor::visit(FunDec* f) {
+    entornoFuncion = true;
+    memoria.clear();
+    offset = -8;
+    labelcont = 0;
+    profundidad = 0;
+    nombreFuncion = f->nombre;
+    perfilFuncion = perfil ? perfil->funcion(f) : nullptr;
+    int size = f->parametros.size();
+    regiones.clear();
+    UsoMarco uso = analizarCuerpo(f->cuerpo, memoriaGlobal, regiones);
+    int enRegistros = min(size, 6);
+    int ocupados = 8 * (enRegistros + uso.locales + uso.registros);
+    hoja = uso.hoja && ocupados + 8 * uso.temporales <= ZONA_ROJA;
+    marco = hoja ? "(%rsp)" : "(%rbp)";
+    baseTemporales = ocupados;
+    out << ".globl " << f->nombre << '\n';
+    out << ".type " << f->nombre << ", @function\n";
+    out << f->nombre <<  ":\n";
+    ubicar(f->linea, f->columna);
+    if (!hoja) {
+        out << " pushq %rbp\n";
+        out << " movq %rsp, %rbp\n";
+    }
+    for (int i = 0; i < size; i++) {
+        if (i >= 6) {
+            // el séptimo y siguientes ya están en la pila del llamador,
+            // encima de la dirección de retorno
+            memoria[f->parametros[i]] = (hoja ? 8 : 16) + 8 * (i - 6);
+            continue;
+        }
+        memoria[f->parametros[i]]=offset;
+        out << " movq " << string_view(ARG_REGS[i]) << "," << offset << marco << '\n';
+        offset -= 8;
+    }
+    f->cuerpo->vardecs->accept(this);
+    guardados.clear();
+    for (int i = 0; i < uso.registros; i++) {
+        guardados.push_back(offset);
+        offset -= 8;
+    }
+    contar(0, "entradas");
+    if (hoja) {
+        TRAZA(TRAZA_INFO, "codegen: " << f->nombre << " es hoja, usa " << ocupados + 8 * uso.temporales
+              << " bytes de la zona roja");
+        for (int i = 0; i < uso.registros; i++) {
+            out << " movq " << string_view(REGISTROS_FOR[i]) << ", " << guardados[i] << marco << '\n';
+        }
+        f->cuerpo->slist->accept(this);
+        restaurarRegistros();
+        out << "ret\n";
+    } else {
+        int reserva = (ocupados + 15) & ~15;
+        TRAZA(TRAZA_INFO, "codegen: " << f->nombre << " reserva " << reserva << " bytes de pila");
+        if (reserva) out << " subq $" << reserva << ", %rsp\n";
+        // una función memoizada se llama a sí misma, así que nunca es hoja
+        // (salvo que el optimizador haya quitado la llamada). Si los
+        // argumentos ya están en la tabla vuelve antes de tocar los
+        // registros que preserva.
+        if (f->memoizar) {
+            entradaMemo(f);
+            out << " cmpq $0, 24(%rcx)\n"
+                   " je .Lmemo_" << f->nombre << '\n';
+            for (size_t i = 0; i < f->parametros.size(); i++) {
+                out << " movq ";
+                variable(f->parametros[i]);
+                out << ", %rdx\n"
+                       " cmpq %rdx, " << 8 * (int) i << "(%rcx)\n"
+                       " jne .Lmemo_" << f->nombre << '\n';
+            }
+            out << " movq 16(%rcx), %rax\n"
+                   "leave\n"
+                   "ret\n"
+                   ".Lmemo_" << f->nombre << ":\n";
+        }
+        for (int i = 0; i < uso.registros; i++) {
+            out << " movq " << string_view(REGISTROS_FOR[i]) << ", " << guardados[i] << marco << '\n';
+        }
+        f->cuerpo->slist->accept(this);
+        out << ".end_"<< f->nombre << ":\n";
+        if (f->memoizar) {
+            // los parámetros no se reasignan: siguen siendo las claves
+            entradaMemo(f);
+            for (size_t i = 0; i < f->parametros.size(); i++) {
+                out << " movq ";
+                variable(f->parametros[i]);
+                out << ", %rdx\n"
+                       " movq %rdx, " << 8 * (int) i << "(%rcx)\n";
+            }
+            out << " movq %rax, 16(%rcx)\n"
+                   " movq $1, 24(%rcx)\n";
+        }
+        restaurarRegistros();
+        out << "leave\n";
+        out << "ret\n";
+    }
+    out << ".size " << f->nombre << ", .-" << f->nombre << '\n';
+    if (f->memoizar && !hoja) {
+        out << ".local lab20_memo_" << f->nombre << '\n'
+            << ".comm lab20_memo_" << f->nombre << ", " << (32 << BITS_MEMO) << ", 32\n";
+    }
+    generarContadores(f);
+    hoja = false;
+    marco = "(%rbp)";
+    entornoFuncion = false;
+}
+
+int GenCodeVisitor::visit(FCallExp* exp) {
+    evaluar(exp);
+    return 0;
+}
+
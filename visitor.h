@@ -1,83 +1,194 @@
-#ifndef VISITOR_H
-#define VISITOR_H
-#include "exp.h"
-#include <list>
-#include <vector>
-#include <unordered_map>
-#include <string>
-using namespace std;
-
-class BinaryExp;
-class NumberExp;
-class BoolExp;
-class IdentifierExp;
-class AssignStatement;
-class PrintStatement;
-class IfStatement;
-class WhileStatement;
-class VarDec;
-class VarDecList;
-class StatementList;
-class Body;
-class FCallExp;
-class FunDec;
-class FunDecList;
-class ReturnStatement;
-class Program;
-
-
-class Visitor {
-public:
-    // 
-    virtual void visit(Program* p) = 0;
-    virtual int visit(BinaryExp* exp) = 0;
-    virtual int visit(NumberExp* exp) = 0;
-    virtual int visit(BoolExp* exp) = 0;
-    virtual int visit(IdentifierExp* exp) = 0;
-    virtual int visit(FCallExp* exp) = 0;
-    virtual void visit(ReturnStatement* stm) = 0;
-    virtual void visit(FunDec* f)=0;
-    virtual void visit(FunDecList* f)=0;
-    virtual void visit(AssignStatement* stm) = 0;
-    virtual void visit(PrintStatement* stm) = 0;
-    virtual void visit(IfStatement* stm) = 0;
-    virtual void visit(WhileStatement* stm) = 0;
-    virtual void visit(VarDec* stm) = 0;
-    virtual void visit(VarDecList* stm) = 0;
-    virtual void visit(StatementList* stm) = 0;
-    virtual void visit(Body* b) = 0;
-};
-
-
-class GenCodeVisitor : public Visitor {
-private:
-    std::ostream& out;
-public:
-    GenCodeVisitor(std::ostream& out) : out(out) {}
-    void generar(Program* program);
-    unordered_map<string, int> memoria;
-    unordered_map<string, bool> memoriaGlobal;
-    int offset = -8;
-    int labelcont = 0;
-    bool entornoFuncion = false;
-    string nombreFuncion;
-    void visit(Program* p) override;
-    int visit(BinaryExp* exp) override;
-    int visit(NumberExp* exp) override;
-    int visit(BoolExp* exp) override;
-    int visit(IdentifierExp* exp) override;
-    void visit(AssignStatement* stm) override;
-    void visit(PrintStatement* stm) override;
-    int visit(FCallExp* exp) override;
-    void visit(ReturnStatement* stm) override;
-    void visit(FunDec* f) override;
-    void visit(FunDecList* f) override;
-    void visit(IfStatement* stm) override;
-    void visit(WhileStatement* stm) override;
-    void visit(VarDec* stm) override;
-    void visit(VarDecList* stm) override;
-    void visit(StatementList* stm) override;
-    void visit(Body* b) override;
-};
-
+#ifndef VISITOR_H
+#define VISITOR_H
+#include "exp.h"
+#include "emitter.h"
+#include "perfil.h"
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <string>
+using namespace std;
+
+class Exp;
+class Stm;
+class BinaryExp;
+class NumberExp;
+class BoolExp;
+class IdentifierExp;
+class IndexExp;
+class IfExp;
+class AssignStatement;
+class PrintStatement;
+class IfStatement;
+class WhileStatement;
+class ForStatement;
+class VarDec;
+class VarDecList;
+class StatementList;
+class Body;
+class FCallExp;
+class FunDec;
+class FunDecList;
+class ReturnStatement;
+class Program;
+
+
+class Visitor {
+public:
+    // 
+    virtual void visit(Program* p) = 0;
+    virtual int visit(BinaryExp* exp) = 0;
+    virtual int visit(NumberExp* exp) = 0;
+    virtual int visit(BoolExp* exp) = 0;
+    virtual int visit(IdentifierExp* exp) = 0;
+    virtual int visit(IndexExp* exp) = 0;
+    virtual int visit(IfExp* exp) = 0;
+    virtual int visit(FCallExp* exp) = 0;
+    virtual void visit(ReturnStatement* stm) = 0;
+    virtual void visit(FunDec* f)=0;
+    virtual void visit(FunDecList* f)=0;
+    virtual void visit(AssignStatement* stm) = 0;
+    virtual void visit(PrintStatement* stm) = 0;
+    virtual void visit(IfStatement* stm) = 0;
+    virtual void visit(WhileStatement* stm) = 0;
+    virtual void visit(ForStatement* stm) = 0;
+    virtual void visit(VarDec* stm) = 0;
+    virtual void visit(VarDecList* stm) = 0;
+    virtual void visit(StatementList* stm) = 0;
+    virtual void visit(Body* b) = 0;
+};
+
+
+// Una global que un bucle sin llamadas lleva en un registro mientras
+// corre: se carga al entrar y, si el bucle la asigna, se guarda al salir.
+struct GlobalEnRegistro {
+    string nombre;
+    string_view registro;
+    bool asignada;
+};
+
+class GenCodeVisitor : public Visitor {
+private:
+    Emitter& out;
+    unordered_map<string, int> memoria;
+    unordered_map<string, bool> memoriaGlobal;
+    // elementos de los arreglos globales (memoria[a] de un arreglo local es
+    // la dirección de a[0], el más bajo de sus huecos)
+    unordered_map<string, int> longitudGlobal;
+    int offset = -8;
+    int labelcont = 0;
+    bool entornoFuncion = false;
+    string nombreFuncion;
+    // pilas explícitas de evaluar() y generarSentencias(); se reutilizan
+    struct MarcoExp {
+        Exp* e = nullptr;
+        size_t etapa = 0;
+        int base = 0;   // llamadas: profundidad con el área de argumentos ya reservada;
+                        // ifexp con saltos: número de sus etiquetas
+        int area = 0;   // llamadas: bytes de argumentos en pila más el relleno
+        int ultima = 0; // llamadas: último argumento que no es una hoja (-1 si no hay)
+    };
+    struct MarcoStm {
+        Body* cuerpo;
+        Stm* stm;
+        int etapa;
+        int label;
+        // if: el else va primero; while: la condición va al final del cuerpo
+        bool invertido = false;
+    };
+    // Un for en curso: dónde viven su variable y su límite mientras corre el
+    // cuerpo. Sin registro la variable queda en memoria (una global, que las
+    // llamadas del cuerpo pueden leer, o cuando no alcanzan los registros).
+    struct MarcoFor {
+        string variable;
+        string_view registro;
+        string limite;      // operando de cmpq: $N, un registro o un hueco del marco
+        int tomados;        // REGISTROS_FOR ocupados, contando los de los for que lo encierran
+    };
+    vector<MarcoExp> pilaExp;
+    vector<MarcoStm> pilaStm;
+    vector<MarcoFor> pilaFor;
+    unordered_map<string, string_view> enRegistro;
+    // huecos del marco donde se guardan los REGISTROS_FOR que usa la función
+    vector<int> guardados;
+    void abrirFor(ForStatement* f, int label);
+    void cerrarFor(int label);
+    void restaurarRegistros();
+    // bucles de la función en curso que llevan globales en registros; no
+    // se anidan, así que hay a lo sumo uno abierto
+    unordered_map<Stm*, vector<GlobalEnRegistro>> regiones;
+    Stm* region = nullptr;
+    void abrirRegion(Stm* bucle);
+    void cerrarRegion(Stm* bucle);
+    void guardarGlobales();
+    // bytes apilados por la expresión en curso; en cada sentencia vale 0 y
+    // %rsp está alineado a 16 porque la reserva del marco lo está
+    int profundidad = 0;
+    // función hoja: sin marco, todo direccionado desde %rsp en la zona roja
+    bool hoja = false;
+    string_view marco = "(%rbp)";
+    int baseTemporales = 0;
+    void apilar();
+    void desapilar();
+    bool diferido(const vector<Exp*>& args, size_t i, int ultima);
+    void variable(const string& nombre);
+    void operando(Exp* hoja);
+    void prepararElemento(const string& arreglo);
+    void elemento(const string& arreglo, string_view indice);
+    void generarVectorial(WhileStatement* w);
+    void evaluar(Exp* raiz, bool soloFlags = false);
+    const char* condicion(Exp* c);
+    void saltar(Exp* condicion, bool siVerdadera, const char* destino, int label);
+    void generarSentencias(Body* cuerpo, Stm* stm);
+    // --profile-generate: archivo que escribe el programa al terminar (vacío
+    // si no se instrumenta) y claves de los contadores de la función en curso
+    string rutaPerfil;
+    vector<string> contadores;
+    void contar(int sitio, const char* contador);
+    void generarContadores(FunDec* f);
+    // --profile-use
+    const Perfil* perfil = nullptr;
+    const PerfilFuncion* perfilFuncion = nullptr;
+    CuentasSitio cuentas(int sitio) const;
+    // -g: fuente de las directivas .file/.loc (vacío sin información de
+    // depuración)
+    string archivoFuente;
+    void ubicar(int linea, int columna);
+    // lab20_imprimir y su buffer (print)
+    void generarRuntime();
+    // --memoize (FunDec::memoizar)
+    void entradaMemo(FunDec* f);
+public:
+    GenCodeVisitor(Emitter& out) : out(out) {}
+    void generar(Program* program);
+    void generarCabecera(VarDecList* globales);
+    void generarPie();
+    const unordered_map<string, bool>& globales() const { return memoriaGlobal; }
+    void usarGlobales(const unordered_map<string, bool>& g) { memoriaGlobal = g; }
+    // las funciones tienen que venir con sus sitios numerados (perfil.h)
+    void instrumentar(const string& ruta) { rutaPerfil = ruta; }
+    void usarPerfil(const Perfil* p) { perfil = p; }
+    void depurar(const string& archivo) { archivoFuente = archivo; }
+    void visit(Program* p) override;
+    int visit(BinaryExp* exp) override;
+    int visit(NumberExp* exp) override;
+    int visit(BoolExp* exp) override;
+    int visit(IdentifierExp* exp) override;
+    int visit(IndexExp* exp) override;
+    int visit(IfExp* exp) override;
+    void visit(AssignStatement* stm) override;
+    void visit(PrintStatement* stm) override;
+    int visit(FCallExp* exp) override;
+    void visit(ReturnStatement* stm) override;
+    void visit(FunDec* f) override;
+    void visit(FunDecList* f) override;
+    void visit(IfStatement* stm) override;
+    void visit(WhileStatement* stm) override;
+    void visit(ForStatement* stm) override;
+    void visit(VarDec* stm) override;
+    void visit(VarDecList* stm) override;
+    void visit(StatementList* stm) override;
+    void visit(Body* b) override;
+};
+
 #endif // VISITOR_H
\ No newline at end of file